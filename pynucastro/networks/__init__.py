@@ -22,12 +22,19 @@ the support routines to generate a C++ network that can be incorporated
 into the AMReX-Astro Microphysics routines supported by astrophysical
 hydrodynamics codes.
 
+:meth:`network_description <pynucastro.networks.network_description>`:
+a binary description of a network, and a generic C++ engine that
+evaluates any network from its description at runtime.
+
 """
 
 #__all__ = ["python_network", "rate_collection", "sympy_network_support"]
 
 from .amrexastro_cxx_network import AmrexAstroCxxNetwork
 from .base_cxx_network import BaseCxxNetwork
+from .network_description import (read_network_description,
+                                  write_network_description,
+                                  write_runtime_engine)
 from .nse_network import NSENetwork
 from .numpy_network import NumpyNetwork
 from .python_network import PythonNetwork
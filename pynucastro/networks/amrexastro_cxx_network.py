@@ -20,14 +20,28 @@ class AmrexAstroCxxNetwork(BaseCxxNetwork):
         except KeyError:
             disable_rate_params = []
 
+        # the tabular rates are interpolated in log(T) either linearly
+        # or with a monotone cubic
+        tabular_interpolation = kwargs.pop("tabular_interpolation", "linear")
+        if tabular_interpolation not in ("linear", "cubic"):
+            raise ValueError(f"unknown tabular_interpolation '{tabular_interpolation}'")
+
+        # derived rates whose forward rate is in the network can be
+        # computed by scaling the forward rate by detailed balance
+        derived_from_forward = kwargs.pop("derived_from_forward", False)
+
         # Initialize BaseCxxNetwork parent class
         super().__init__(*args, **kwargs)
 
         self.ftags['<rate_param_tests>'] = self._rate_param_tests
         self.ftags['<rate_indices>'] = self._fill_rate_indices
         self.ftags['<npa_index>'] = self._fill_npa_index
+        self.ftags['<rate_profile_package>'] = self._rate_profile_package
+        self.ftags['<tabular_interpolation>'] = self._tabular_interpolation
 
         self.disable_rate_params = disable_rate_params
+        self.tabular_interpolation = tabular_interpolation
+        self.derived_from_forward = derived_from_forward
         self.function_specifier = "AMREX_GPU_HOST_DEVICE AMREX_INLINE"
         self.dtype = "Real"
 
@@ -40,6 +54,14 @@ class AmrexAstroCxxNetwork(BaseCxxNetwork):
 
         return glob.glob(template_pattern)
 
+    def _rate_profile_package(self, n_indent, of):
+        if self.profile_rates:
+            of.write(f"{self.indent*n_indent}CEXE_headers += rate_profile.H\n")
+
+    def _tabular_interpolation(self, n_indent, of):
+        cubic = "true" if self.tabular_interpolation == "cubic" else "false"
+        of.write(f"{self.indent*n_indent}constexpr bool tabular_cubic_temp = {cubic};\n")
+
     def _rate_param_tests(self, n_indent, of):
 
         for _, r in enumerate(self.rates):
@@ -68,6 +90,15 @@ class AmrexAstroCxxNetwork(BaseCxxNetwork):
 
         if odir is None:
             odir = os.getcwd()
+
+        # write a binary copy of each table, which init_tabular maps
+        # into memory instead of parsing the text table.  It records
+        # the size and time of the text table copied next to it
+        for r in self.tabular_rates:
+            table_file = os.path.join(odir, r.table_file)
+            r.write_binary_table(os.path.join(odir, r.table_binary_file),
+                                 source_file=table_file if os.path.isfile(table_file) else None)
+
         # create a .net file with the nuclei properties
         with open(os.path.join(odir, "pynucastro.net"), "w") as of:
             for nuc in self.unique_nuclei:
@@ -85,6 +116,10 @@ class AmrexAstroCxxNetwork(BaseCxxNetwork):
         # write the _parameters file
         with open(os.path.join(odir, "_parameters"), "w") as of:
             of.write("@namespace: network\n\n")
+            if self.tabular_rates:
+                # read each group of tables when it is first used,
+                # instead of all of them at initialization
+                of.write("lazy_tabular_tables    int     0\n\n")
             if self.disable_rate_params:
                 for r in self.disable_rate_params:
                     of.write(f"disable_{r.cname()}    int     0\n")
@@ -5,6 +5,7 @@ comprised of the rates that are passed in.
 """
 
 
+import io
 import itertools
 import os
 import re
@@ -18,6 +19,7 @@ import sympy
 
 from pynucastro.networks.rate_collection import RateCollection
 from pynucastro.networks.sympy_network_support import SympyRates
+from pynucastro.rates import DerivedRate, TableIndex
 from pynucastro.screening import get_screening_map
 
 
@@ -27,16 +29,29 @@ class BaseCxxNetwork(ABC, RateCollection):
 
     """
 
-    def __init__(self, *args, **kwargs):
+    def __init__(self, *args, profile_rates=False, **kwargs):
         """Initialize the C++ network.  We take a single argument: a list
-        of rate files that will make up the network
+        of rate files that will make up the network.  If profile_rates
+        is True, evaluate_rates times each rate, screening block and
+        table lookup, and rate_profile::report() lists the time spent
+        on each rate.
 
         """
 
+        self.profile_rates = profile_rates
+
+        # networks that can compute derived rates from their forward
+        # rate set this
+        self.derived_from_forward = False
+
         super().__init__(*args, **kwargs)
 
-        # Get the template files for writing this network code
+        # Get the template files for writing this network code.  The
+        # rate profiler is shared by all of the C++ networks
         self.template_files = self._get_template_files()
+        if self.profile_rates:
+            self.template_files.append(os.path.join(self.pynucastro_dir, 'templates',
+                                                    'cxx-common', 'rate_profile.H.template'))
 
         self.symbol_rates = SympyRates()
 
@@ -46,6 +61,11 @@ class BaseCxxNetwork(ABC, RateCollection):
         self.jac_null_entries = None
         self.solved_jacobian = False
 
+        # the common subexpressions of the RHS and Jacobian, found
+        # when they are first written
+        self.ydot_cse = None
+        self.jac_cse = None
+
         self.function_specifier = "inline"
         self.dtype = "double"
 
@@ -62,7 +82,9 @@ class BaseCxxNetwork(ABC, RateCollection):
         self.ftags['<declare_tables>'] = self._declare_tables
         self.ftags['<table_declare_meta>'] = self._table_declare_meta
         self.ftags['<table_init_meta>'] = self._table_init_meta
+        self.ftags['<table_loads>'] = self._table_loads
         self.ftags['<compute_tabular_rates>'] = self._compute_tabular_rates
+        self.ftags['<evaluate_all_tabular_rates>'] = self._evaluate_all_tabular_rates
         self.ftags['<ydot>'] = self._ydot
         self.ftags['<enuc_add_energy_rate>'] = self._enuc_add_energy_rate
         self.ftags['<jacnuc>'] = self._jacnuc
@@ -75,10 +97,21 @@ class BaseCxxNetwork(ABC, RateCollection):
         self.ftags['<part_fun_data>'] = self._fill_partition_function_data
         self.ftags['<part_fun_cases>'] = self._fill_partition_function_cases
         self.ftags['<spin_state_cases>'] = self._fill_spin_state_cases
+        self.ftags['<pf_cache_members>'] = self._pf_cache_members
+        self.ftags['<fill_pf_cache>'] = self._fill_pf_cache
+        self.ftags['<fill_partition_function_cache>'] = self._fill_partition_function_cache
+        self.ftags['<rate_profile_include>'] = self._rate_profile_include
+        self.ftags['<gpu_qualifiers_include>'] = self._gpu_qualifiers_include
+        self.ftags['<rate_profile_report>'] = self._rate_profile_report
         self.indent = '    '
 
         self.num_screen_calls = None
 
+        # the most uniformly spaced pieces a tabular rate's grid can be
+        # made of for its index to be computed instead of searched for
+        # -- this matches max_grid_segments in table_rates.H
+        self.max_grid_segments = 4
+
     @abstractmethod
     def _get_template_files(self):
         # This method should be overridden by derived classes
@@ -116,7 +149,8 @@ class BaseCxxNetwork(ABC, RateCollection):
                         sys.exit(f"unable to create directory {odir}")
                 outfile = os.path.normpath(odir + "/" + outfile)
 
-            with open(tfile) as ifile, open(outfile, "w") as of:
+            of = io.StringIO()
+            with open(tfile) as ifile:
                 for l in ifile:
                     ls = l.strip()
                     foundkey = False
@@ -128,6 +162,8 @@ class BaseCxxNetwork(ABC, RateCollection):
                     if not foundkey:
                         of.write(l)
 
+            self._write_if_changed(outfile, of.getvalue())
+
         # Copy any tables in the network to the current directory
         # if the table file cannot be found, print a warning and continue.
         for tr in self.tabular_rates:
@@ -139,6 +175,19 @@ class BaseCxxNetwork(ABC, RateCollection):
                 else:
                     warnings.warn(UserWarning(f'Table data file {tr.table_file} not found.'))
 
+    @staticmethod
+    def _write_if_changed(outfile, contents):
+        """Write contents to outfile, unless it already holds exactly
+        that, so a build only redoes the files that changed when a
+        network is regenerated."""
+
+        if os.path.isfile(outfile):
+            with open(outfile) as f:
+                if f.read() == contents:
+                    return
+        with open(outfile, "w") as f:
+            f.write(contents)
+
     def compose_ydot(self):
         """create the expressions for dYdt for the nuclei, where Y is the
         molar fraction.
@@ -170,6 +219,7 @@ class BaseCxxNetwork(ABC, RateCollection):
 
         self.ydot_out_result = ydot
         self.solved_ydot = True
+        self.ydot_cse = None
 
     def compose_jacobian(self):
         """Create the Jacobian matrix, df/dY"""
@@ -193,6 +243,176 @@ class BaseCxxNetwork(ABC, RateCollection):
         self.jac_out_result = jac_sym
         self.jac_null_entries = jac_null
         self.solved_jacobian = True
+        self.jac_cse = None
+
+    def _cse(self, exprs, prefix):
+        """Eliminate the common subexpressions across the list of sympy
+        expressions exprs.  This returns a list of (name, value) pairs
+        for the temporaries, in the order they need to be computed, and
+        the reduced expressions, all as C++ code."""
+
+        # sympy.cse does not see that products differing only by a
+        # number (like 1.0*a*b and -2.0*a*b) are the same, so we pull
+        # the numeric coefficient out of each term first, eliminate
+        # over the bare products, and put the coefficients back after
+
+        split = []
+        products = []
+        for e in exprs:
+            terms = []
+            for t in sympy.Add.make_args(e):
+                coeff, rest = t.as_coeff_Mul()
+                terms.append((coeff, len(products)))
+                products.append(rest)
+            split.append(terms)
+
+        replacements, reduced = sympy.cse(products, symbols=sympy.numbered_symbols(prefix))
+
+        # a temporary that is just a number times another symbol (like
+        # a negation) saves no work, so we put it back in the
+        # expressions that use it
+
+        inlined = {}
+        kept = []
+        for sym, value in replacements:
+            value = value.xreplace(inlined)
+            coeff, rest = value.as_coeff_Mul()
+            if coeff.is_Number and rest.is_Symbol:
+                inlined[sym] = value
+            else:
+                kept.append((sym, value))
+        reduced = [e.xreplace(inlined) for e in reduced]
+
+        # number the remaining temporaries consecutively
+        renamed = {sym: sympy.Symbol(f"{prefix}{i}") for i, (sym, _) in enumerate(kept)}
+        kept = [(renamed[sym], value.xreplace(renamed)) for sym, value in kept]
+        reduced = [e.xreplace(renamed) for e in reduced]
+
+        def drop_unit_coeffs(e):
+            # a coefficient of 1.0 or -1.0 is just a sign
+            def is_unit(x):
+                return (x.is_Mul and isinstance(x.args[0], sympy.Float) and
+                        abs(float(x.args[0])) == 1.0)
+
+            def sign_only(x):
+                rest = sympy.Mul(*x.args[1:])
+                return rest if x.args[0] > 0 else -rest
+
+            return e.replace(is_unit, sign_only)
+
+        kept = [(sym, drop_unit_coeffs(value)) for sym, value in kept]
+        reduced = [drop_unit_coeffs(sympy.Add(*[coeff * reduced[k] for coeff, k in terms]))
+                   for terms in split]
+
+        def to_cxx(e):
+            return self.symbol_rates.cxxify(sympy.cxxcode(e, precision=15, standard="c++11"))
+
+        temps = [(str(sym), to_cxx(value)) for sym, value in kept]
+        return temps, [to_cxx(e) for e in reduced]
+
+    def get_ydot_cse(self, nuclei=None):
+        """Return the temporaries and the C++ expressions for each term in
+        the ydot equations, with the subexpressions shared by any of the
+        terms eliminated.  The terms are a dict keyed by (nucleus, pair
+        index, 0 for forward or 1 for reverse).  If nuclei is given,
+        only the equations of those nuclei are considered."""
+
+        if nuclei is None and self.ydot_cse is not None:
+            return self.ydot_cse
+
+        keys = []
+        exprs = []
+        for n in self.unique_nuclei if nuclei is None else nuclei:
+            if self.ydot_out_result[n] is None:
+                continue
+            for j, pair in enumerate(self.ydot_out_result[n]):
+                for i, term in enumerate(pair):
+                    if term is not None:
+                        keys.append((n, j, i))
+                        exprs.append(term)
+
+        temps, reduced = self._cse(exprs, "ydot_tmp")
+        ydot_cse = (temps, dict(zip(keys, reduced)))
+
+        if nuclei is None:
+            self.ydot_cse = ydot_cse
+        return ydot_cse
+
+    def get_jacobian_cse(self, rows=None):
+        """Return the temporaries and the C++ expressions for the non-null
+        Jacobian entries, with the subexpressions shared by any of the
+        entries eliminated.  The entries are a dict keyed by their index
+        in jac_out_result.  If rows is given, only the entries of
+        those rows (as indices into unique_nuclei) are considered."""
+
+        if rows is None and self.jac_cse is not None:
+            return self.jac_cse
+
+        n_unique_nuclei = len(self.unique_nuclei)
+        keys = [idx for idx, is_null in enumerate(self.jac_null_entries)
+                if not is_null and (rows is None or idx // n_unique_nuclei in rows)]
+        temps, reduced = self._cse([self.jac_out_result[idx] for idx in keys], "jac_tmp")
+        jac_cse = (temps, dict(zip(keys, reduced)))
+
+        if rows is None:
+            self.jac_cse = jac_cse
+        return jac_cse
+
+    def _write_cse_temps(self, n_indent, of, temps):
+        for name, value in temps:
+            of.write(f"{self.indent*n_indent}const {self.dtype} {name} = {value};\n")
+        if temps:
+            of.write("\n")
+
+    def get_jacobian_sparsity(self):
+        """Return the sparsity pattern of the species Jacobian in
+        compressed sparse row form, as the lists (row_ptr, col_index)
+        with 0-based species indices.  The nonzeros of row i are
+        col_index[row_ptr[i]:row_ptr[i+1]]."""
+
+        if not self.solved_jacobian:
+            self.compose_jacobian()
+
+        n_unique_nuclei = len(self.unique_nuclei)
+
+        row_ptr = [0]
+        col_index = []
+        for irow in range(n_unique_nuclei):
+            for jcol in range(n_unique_nuclei):
+                if not self.jac_null_entries[n_unique_nuclei*irow + jcol]:
+                    col_index.append(jcol)
+            row_ptr.append(len(col_index))
+
+        return row_ptr, col_index
+
+    def get_lu_sparsity(self):
+        """Return the sparsity pattern of the LU factorization (without
+        pivoting) of I - gamma J, including the fill-in, in the same CSR
+        form as get_jacobian_sparsity."""
+
+        row_ptr, col_index = self.get_jacobian_sparsity()
+
+        n_unique_nuclei = len(self.unique_nuclei)
+
+        rows = [set(col_index[row_ptr[irow]:row_ptr[irow+1]]) | {irow}
+                for irow in range(n_unique_nuclei)]
+
+        # eliminating column k adds row k's upper part to every
+        # row below it with a nonzero in column k
+
+        for k in range(n_unique_nuclei):
+            upper = {j for j in rows[k] if j > k}
+            for irow in range(k+1, n_unique_nuclei):
+                if k in rows[irow]:
+                    rows[irow] |= upper
+
+        lu_row_ptr = [0]
+        lu_col_index = []
+        for irow in range(n_unique_nuclei):
+            lu_col_index += sorted(rows[irow])
+            lu_row_ptr.append(len(lu_col_index))
+
+        return lu_row_ptr, lu_col_index
 
     def _compute_screening_factors(self, n_indent, of):
         if not self.do_screening:
@@ -215,7 +435,10 @@ class BaseCxxNetwork(ABC, RateCollection):
                 # compiler to evaluate the screen factor at compile time.
                 of.write(f'\n{self.indent*(n_indent+1)}static_assert(scn_fac.z1 == {float(scr.n1.Z)}_rt);\n\n')
 
-                of.write(f'\n{self.indent*(n_indent+1)}actual_screen<do_T_derivatives>(pstate, scn_fac, scor, dscor_dt);\n')
+                of.write('\n')
+                self._write_profiled(n_indent+1, of,
+                                     ['actual_screen<do_T_derivatives>(pstate, scn_fac, scor, dscor_dt);'],
+                                     scr.rates, screen=True)
 
                 of.write(f'{self.indent*n_indent}' + '}\n\n')
 
@@ -233,7 +456,10 @@ class BaseCxxNetwork(ABC, RateCollection):
 
                 of.write(f'\n{self.indent*(n_indent+1)}static_assert(scn_fac2.z1 == {float(scr.n1.Z)}_rt);\n\n')
 
-                of.write(f'\n{self.indent*(n_indent+1)}actual_screen<do_T_derivatives>(pstate, scn_fac2, scor2, dscor2_dt);\n')
+                of.write('\n')
+                self._write_profiled(n_indent+1, of,
+                                     ['actual_screen<do_T_derivatives>(pstate, scn_fac2, scor2, dscor2_dt);'],
+                                     scr.rates, screen=True)
 
                 of.write(f'\n{self.indent*n_indent}' + '}\n\n')
 
@@ -270,6 +496,45 @@ class BaseCxxNetwork(ABC, RateCollection):
 
         self.num_screen_calls = max(1, len(screening_map))
 
+    def _write_profiled(self, n_indent, of, lines, rates, screen=False):
+        """Write the C++ statements in lines, and if we are profiling,
+        time them and add the time to the rates, split evenly between
+        them -- to their screening time if screen is True, or else to
+        their evaluation time."""
+
+        idnt = self.indent*n_indent
+
+        if not self.profile_rates:
+            for l in lines:
+                of.write(f"{idnt}{l}\n")
+            return
+
+        if screen:
+            stop = "stop_screen"
+        else:
+            stop = "stop"
+        ks = ", ".join(f"k_{r.cname()}" for r in rates)
+
+        of.write(f"{idnt}{{\n")
+        of.write(f"{idnt}    const auto tstart = rate_profile::now();\n")
+        for l in lines:
+            of.write(f"{idnt}    {l}\n")
+        of.write(f"{idnt}    rate_profile::{stop}(tstart, {ks});\n")
+        of.write(f"{idnt}}}\n")
+
+    def _gpu_qualifiers_include(self, n_indent, of):
+        of.write(f"{self.indent*n_indent}#include <AMReX_GpuQualifiers.H>\n")
+
+    def _rate_profile_include(self, n_indent, of):
+        if self.profile_rates:
+            of.write(f"{self.indent*n_indent}#include <rate_profile.H>\n")
+
+    def _rate_profile_report(self, n_indent, of):
+        if self.profile_rates:
+            of.write("\n")
+            of.write(f"{self.indent*n_indent}std::cout << std::endl;\n")
+            of.write(f"{self.indent*n_indent}rate_profile::report(std::cout);\n")
+
     def _nrat_reaclib(self, n_indent, of):
         # Writes the number of Reaclib rates
         of.write(f'{self.indent*n_indent}const int NrateReaclib = {len(self.reaclib_rates + self.derived_rates)};\n')
@@ -298,62 +563,220 @@ class BaseCxxNetwork(ABC, RateCollection):
     def _table_num(self, n_indent, of):
         of.write(f'{self.indent*n_indent}const int num_tables = {len(self.tabular_rates)};\n')
 
-    def _declare_tables(self, n_indent, of):
+    def _table_grid(self, segments):
+        # the grid as a table_grid_t, if it is made of few enough
+        # uniform pieces -- otherwise it is searched
+        if len(segments) > self.max_grid_segments:
+            return "table_grid_t{}"
+        origin = ", ".join(f"{x0!r}_rt" for _, x0, _ in segments)
+        inv_spacing = ", ".join(f"{1.0/dx!r}_rt" for _, _, dx in segments)
+        first = ", ".join(f"{i+1}" for i, _, _ in segments)
+        return f"table_grid_t{{{len(segments)}, {{{origin}}}, {{{inv_spacing}}}, {{{first}}}}}"
+
+    def _table_groups(self):
+        """Group the tabular rates whose tables have the same grids, so
+        they can be stored together and evaluated at once.  Returns a
+        list of (name, rates) pairs."""
+
+        groups = {}
         for r in self.tabular_rates:
-            idnt = self.indent*n_indent
+            ntemp = r.table_temp_lines
+            key = (r.table_num_vars,
+                   r.tabular_data_table[::ntemp, TableIndex.RHOY.value].tobytes(),
+                   r.tabular_data_table[:ntemp, TableIndex.T.value].tobytes())
+            groups.setdefault(key, []).append(r)
+
+        return [(f"table_group_{n}", rates) for n, rates in enumerate(groups.values(), 1)]
+
+    def _tabular_rate_order(self):
+        # the tabular rates in the order evaluate_all_tabular_rates
+        # stores them -- group by group
+        return [r for _, rates in self._table_groups() for r in rates]
+
+    def _declare_tables(self, n_indent, of):
+        idnt = self.indent*n_indent
+
+        for name, rates in self._table_groups():
+            r = rates[0]
 
-            of.write(f'{idnt}extern AMREX_GPU_MANAGED table_t {r.table_index_name}_meta;\n')
-            of.write(f'{idnt}extern AMREX_GPU_MANAGED Array3D<Real, 1, {r.table_temp_lines}, 1, {r.table_rhoy_lines}, 1, {r.table_num_vars}> {r.table_index_name}_data;\n')
-            of.write(f'{idnt}extern AMREX_GPU_MANAGED Array1D<Real, 1, {r.table_rhoy_lines}> {r.table_index_name}_rhoy;\n')
-            of.write(f'{idnt}extern AMREX_GPU_MANAGED Array1D<Real, 1, {r.table_temp_lines}> {r.table_index_name}_temp;\n')
+            of.write(f'{idnt}// {", ".join(t.table_file for t in rates)}\n\n')
+
+            # the grids are returned by functions, so they are
+            # constants in device code as well
+            for axis, segments in (("rhoy", r.table_rhoy_segments), ("temp", r.table_temp_segments)):
+                of.write(f'{idnt}AMREX_GPU_HOST_DEVICE AMREX_INLINE\n')
+                of.write(f'{idnt}constexpr table_grid_t {name}_{axis}_grid() {{\n')
+                of.write(f'{idnt}    return {self._table_grid(segments)};\n')
+                of.write(f'{idnt}}}\n\n')
+
+            of.write(f'{idnt}extern AMREX_GPU_MANAGED table_t {name}_meta;\n')
+            of.write(f'{idnt}extern AMREX_GPU_MANAGED Array3D<Real, 1, {len(rates)} * packed_vars, 1, {r.table_temp_lines}, 1, {r.table_rhoy_lines}> {name}_data;\n')
+            of.write(f'{idnt}extern AMREX_GPU_MANAGED Array1D<Real, 1, {r.table_rhoy_lines}> {name}_rhoy;\n')
+            of.write(f'{idnt}extern AMREX_GPU_MANAGED Array1D<Real, 1, {r.table_temp_lines}> {name}_temp;\n\n')
+
+            of.write(f'{idnt}extern std::once_flag {name}_loaded;\n')
+            of.write(f'{idnt}void add_{name}_loads(table_loads_t& loads);\n')
+            of.write(f'{idnt}void load_{name}();\n')
             of.write('\n')
 
     def _table_declare_meta(self, n_indent, of):
-        for r in self.tabular_rates:
-            idnt = self.indent*n_indent
+        idnt = self.indent*n_indent
 
-            of.write(f"{idnt}AMREX_GPU_MANAGED table_t {r.table_index_name}_meta;\n")
+        for name, rates in self._table_groups():
+            r = rates[0]
 
-            of.write(f'{idnt}AMREX_GPU_MANAGED Array3D<Real, 1, {r.table_temp_lines}, 1, {r.table_rhoy_lines}, 1, {r.table_num_vars}> {r.table_index_name}_data;\n')
+            of.write(f"{idnt}AMREX_GPU_MANAGED table_t {name}_meta;\n")
 
-            of.write(f'{idnt}AMREX_GPU_MANAGED Array1D<Real, 1, {r.table_rhoy_lines}> {r.table_index_name}_rhoy;\n')
-            of.write(f'{idnt}AMREX_GPU_MANAGED Array1D<Real, 1, {r.table_temp_lines}> {r.table_index_name}_temp;\n\n')
+            of.write(f'{idnt}AMREX_GPU_MANAGED Array3D<Real, 1, {len(rates)} * packed_vars, 1, {r.table_temp_lines}, 1, {r.table_rhoy_lines}> {name}_data;\n')
 
-    def _table_init_meta(self, n_indent, of):
-        for r in self.tabular_rates:
-            idnt = self.indent*n_indent
-            of.write(f'{idnt}{r.table_index_name}_meta.ntemp = {r.table_temp_lines};\n')
-            of.write(f'{idnt}{r.table_index_name}_meta.nrhoy = {r.table_rhoy_lines};\n')
-            of.write(f'{idnt}{r.table_index_name}_meta.nvars = {r.table_num_vars};\n')
-            of.write(f'{idnt}{r.table_index_name}_meta.nheader = {r.table_header_lines};\n\n')
+            of.write(f'{idnt}AMREX_GPU_MANAGED Array1D<Real, 1, {r.table_rhoy_lines}> {name}_rhoy;\n')
+            of.write(f'{idnt}AMREX_GPU_MANAGED Array1D<Real, 1, {r.table_temp_lines}> {name}_temp;\n\n')
 
-            of.write(f'{idnt}init_tab_info({r.table_index_name}_meta, "{r.table_file}", {r.table_index_name}_rhoy, {r.table_index_name}_temp, {r.table_index_name}_data);\n\n')
+    def _table_loads(self, n_indent, of):
+        idnt = self.indent*n_indent
 
-            of.write('\n')
+        for name, rates in self._table_groups():
+            r = rates[0]
+
+            of.write(f'{idnt}std::once_flag {name}_loaded;\n\n')
+
+            # the loads write to different parts of the data, and the
+            # first table of the group writes the grids -- the others
+            # read theirs into scratch arrays, since they are the same
+            of.write(f'{idnt}void add_{name}_loads(table_loads_t& loads)\n')
+            of.write(f'{idnt}{{\n')
+            for k, t in enumerate(rates):
+                of.write(f'{idnt}    loads.emplace_back([] () {{\n')
+                of.write(f'{idnt}        table_t meta = {name}_meta;\n')
+                of.write(f'{idnt}        meta.nheader = {t.table_header_lines};\n')
+                of.write(f'{idnt}        auto table = packed_table({name}_data, {k});\n')
+                if k == 0:
+                    of.write(f'{idnt}        init_tab_info(meta, "{t.table_file}", {name}_rhoy, {name}_temp, table);\n')
+                else:
+                    of.write(f'{idnt}        Array1D<Real, 1, {r.table_rhoy_lines}> rhoy;\n')
+                    of.write(f'{idnt}        Array1D<Real, 1, {r.table_temp_lines}> temp;\n')
+                    of.write(f'{idnt}        init_tab_info(meta, "{t.table_file}", rhoy, temp, table);\n')
+                of.write(f'{idnt}    }});\n')
+            of.write(f'{idnt}}}\n\n')
+
+            of.write(f'{idnt}void load_{name}()\n')
+            of.write(f'{idnt}{{\n')
+            of.write(f'{idnt}    table_loads_t loads;\n')
+            of.write(f'{idnt}    add_{name}_loads(loads);\n')
+            of.write(f'{idnt}    load_tables(loads);\n')
+            of.write(f'{idnt}}}\n\n')
+
+    def _table_init_meta(self, n_indent, of):
+        idnt = self.indent*n_indent
+
+        groups = self._table_groups()
+
+        for name, rates in groups:
+            r = rates[0]
+
+            of.write(f'{idnt}{name}_meta.ntemp = {r.table_temp_lines};\n')
+            of.write(f'{idnt}{name}_meta.nrhoy = {r.table_rhoy_lines};\n')
+            of.write(f'{idnt}{name}_meta.nvars = {r.table_num_vars};\n')
+            of.write(f'{idnt}{name}_meta.nheader = 0;\n\n')
+
+        if not groups:
+            return
+
+        # on GPUs, the tables must be in memory before the first
+        # evaluation, so they are not loaded lazily
+        of.write('#ifndef AMREX_USE_GPU\n')
+        of.write(f'{idnt}if (lazy_tabular_tables) {{\n')
+        of.write(f'{idnt}    amrex::Print() << "tables will be read when they are first used" << std::endl;\n')
+        of.write(f'{idnt}    return;\n')
+        of.write(f'{idnt}}}\n')
+        of.write('#endif\n\n')
+
+        of.write(f'{idnt}table_loads_t loads;\n')
+        for name, _ in groups:
+            of.write(f'{idnt}add_{name}_loads(loads);\n')
+        of.write(f'{idnt}load_tables(loads);\n\n')
+
+        # the groups are loaded, so evaluate_all_tabular_rates won't
+        # load them again
+        for name, _ in groups:
+            of.write(f'{idnt}std::call_once({name}_loaded, [] () {{}});\n')
+
+    def _evaluate_all_tabular_rates(self, n_indent, of):
+        if not self.tabular_rates:
+            return
+
+        idnt = self.indent*n_indent
+
+        of.write(f'{idnt}// Evaluate all of the tabular rates: the logs of rhoY and T are\n')
+        of.write(f'{idnt}// taken once, and the cell is found once for each group of tables.\n')
+        of.write(f'{idnt}// The outputs are indexed by\n')
+        of.write(f'{idnt}//\n')
+        for k, r in enumerate(self._tabular_rate_order(), 1):
+            of.write(f'{idnt}//   {k}: {r.cname()}\n')
+        of.write('\n')
+
+        of.write(f'{idnt}template <typename A>\n')
+        of.write(f'{idnt}AMREX_INLINE AMREX_GPU_HOST_DEVICE\n')
+        of.write(f'{idnt}void\n')
+        of.write(f'{idnt}evaluate_all_tabular_rates(const Real rhoy, const Real temp,\n')
+        of.write(f'{idnt}                           A& rate, A& drate_dt, A& edot_nu, A& edot_gamma)\n')
+        of.write(f'{idnt}{{\n')
+        of.write(f'{idnt}    using namespace rate_tables;\n\n')
+        of.write('#if !AMREX_DEVICE_COMPILE\n')
+        of.write(f'{idnt}    // with lazy_tabular_tables, the tables are read here when\n')
+        of.write(f'{idnt}    // they are first used\n')
+        for name, _ in self._table_groups():
+            of.write(f'{idnt}    std::call_once({name}_loaded, load_{name});\n')
+        of.write('#endif\n\n')
+
+        of.write(f'{idnt}    Real log_rhoy = std::log10(rhoy);\n')
+        of.write(f'{idnt}    Real log_temp = std::log10(temp);\n\n')
+
+        first = 1
+        for name, rates in self._table_groups():
+            of.write(f'{idnt}    tabular_evaluate_group<{len(rates)}>({name}_meta, {name}_rhoy, {name}_temp, {name}_data,\n')
+            of.write(f'{idnt}                              {name}_rhoy_grid(), {name}_temp_grid(),\n')
+            of.write(f'{idnt}                              log_rhoy, log_temp, temp,\n')
+            of.write(f'{idnt}                              {first}, rate, drate_dt, edot_nu, edot_gamma);\n')
+            first += len(rates)
+
+        of.write(f'{idnt}}}\n')
 
     def _compute_tabular_rates(self, n_indent, of):
         if len(self.tabular_rates) > 0:
 
             idnt = self.indent*n_indent
 
-            for r in self.tabular_rates:
+            rates = self._tabular_rate_order()
+
+            of.write(f'{idnt}Array1D<Real, 1, {len(rates)}> rate, drate_dt, edot_nu, edot_gamma;\n\n')
 
-                of.write(f'{idnt}tabular_evaluate({r.table_index_name}_meta, {r.table_index_name}_rhoy, {r.table_index_name}_temp, {r.table_index_name}_data,\n')
-                of.write(f'{idnt}                 rhoy, state.T, rate, drate_dt, edot_nu, edot_gamma);\n')
+            self._write_profiled(n_indent, of,
+                                 ['evaluate_all_tabular_rates(rhoy, state.T, rate, drate_dt, edot_nu, edot_gamma);'],
+                                 rates)
+            of.write('\n')
+
+            for k, r in enumerate(rates, 1):
 
-                of.write(f'{idnt}rate_eval.screened_rates(k_{r.cname()}) = rate;\n')
+                of.write(f'{idnt}rate_eval.screened_rates(k_{r.cname()}) = rate({k});\n')
 
                 of.write(f'{idnt}if constexpr (std::is_same<T, rate_derivs_t>::value) {{\n')
-                of.write(f'{idnt}    rate_eval.dscreened_rates_dT(k_{r.cname()}) = drate_dt;\n')
+                of.write(f'{idnt}    rate_eval.dscreened_rates_dT(k_{r.cname()}) = drate_dt({k});\n')
                 of.write(f'{idnt}}}\n')
 
-                of.write(f'{idnt}rate_eval.enuc_weak += C::Legacy::n_A * {self.symbol_rates.name_y}({r.reactants[0].cindex()}) * (edot_nu + edot_gamma);\n')
+                of.write(f'{idnt}rate_eval.enuc_weak += C::Legacy::n_A * {self.symbol_rates.name_y}({r.reactants[0].cindex()}) * (edot_nu({k}) + edot_gamma({k}));\n')
 
                 of.write('\n')
 
     def _ydot(self, n_indent, of):
-        # Write YDOT
-        for n in self.unique_nuclei:
+        # Write YDOT, with the common subexpressions computed first
+        temps, terms = self.get_ydot_cse()
+        self._write_ydot(n_indent, of, self.unique_nuclei, temps, terms)
+
+    def _write_ydot(self, n_indent, of, nuclei, temps, terms):
+        self._write_cse_temps(n_indent, of, temps)
+
+        for n in nuclei:
             if self.ydot_out_result[n] is None:
                 of.write(f"{self.indent*n_indent}{self.symbol_rates.name_ydot_nuc}({n.cindex()}) = 0.0;\n\n")
                 continue
@@ -375,19 +798,13 @@ class BaseCxxNetwork(ABC, RateCollection):
                     of.write("(")
 
                 if pair[0] is not None:
-                    sol_value = self.symbol_rates.cxxify(sympy.cxxcode(pair[0], precision=15,
-                                                                       standard="c++11"))
-
-                    of.write(f"{sol_value}")
+                    of.write(f"{terms[n, j, 0]}")
 
                 if num == 2:
                     of.write(" + ")
 
                 if pair[1] is not None:
-                    sol_value = self.symbol_rates.cxxify(sympy.cxxcode(pair[1], precision=15,
-                                                                       standard="c++11"))
-
-                    of.write(f"{sol_value}")
+                    of.write(f"{terms[n, j, 1]}")
 
                 if num == 2:
                     of.write(")")
@@ -411,14 +828,20 @@ class BaseCxxNetwork(ABC, RateCollection):
                 of.write(f'{idnt}enuc += C::Legacy::n_A * {self.symbol_rates.name_y}({reactant.cindex()}) * rate_eval.add_energy_rate(k_{r.cname()});\n')
 
     def _jacnuc(self, n_indent, of):
-        # now make the Jacobian
+        # now make the Jacobian, with the common subexpressions computed first
+        temps, entries = self.get_jacobian_cse()
+        self._write_jacnuc(n_indent, of, range(len(self.unique_nuclei)), temps, entries)
+
+    def _write_jacnuc(self, n_indent, of, rows, temps, entries):
+        self._write_cse_temps(n_indent, of, temps)
+
         n_unique_nuclei = len(self.unique_nuclei)
-        for jnj, nj in enumerate(self.unique_nuclei):
+        for jnj in rows:
+            nj = self.unique_nuclei[jnj]
             for ini, ni in enumerate(self.unique_nuclei):
                 jac_idx = n_unique_nuclei*jnj + ini
                 if not self.jac_null_entries[jac_idx]:
-                    jvalue = self.symbol_rates.cxxify(sympy.cxxcode(self.jac_out_result[jac_idx], precision=15,
-                                                                     standard="c++11"))
+                    jvalue = entries[jac_idx]
                     of.write(f"{self.indent*(n_indent)}scratch = {jvalue};\n")
                     of.write(f"{self.indent*n_indent}jac.set({nj.cindex()}, {ni.cindex()}, scratch);\n\n")
 
@@ -431,8 +854,30 @@ class BaseCxxNetwork(ABC, RateCollection):
 
     def _reaclib_rate_functions(self, n_indent, of):
         assert n_indent == 0, "function definitions must be at top level"
+        forward_rates = self._derived_forward_rates()
         for r in self.reaclib_rates + self.derived_rates:
-            of.write(r.function_string_cxx(dtype=self.dtype, specifiers=self.function_specifier))
+            if r.cname() in forward_rates:
+                of.write(r.function_string_cxx(dtype=self.dtype, specifiers=self.function_specifier,
+                                               from_forward=True))
+            else:
+                of.write(r.function_string_cxx(dtype=self.dtype, specifiers=self.function_specifier))
+
+    def _derived_forward_rates(self):
+        """With derived_from_forward, return the forward rate of each
+        derived rate whose forward rate is also in the network, keyed
+        by the cname of the derived rate.  These derived rates are
+        computed from the forward rate instead of from their own
+        sets.  A rate with a single set is left alone, since scaling
+        the forward rate costs an exp as well, and so is a rate whose
+        forward rate is endothermic (see
+        DerivedRate.can_scale_forward)."""
+
+        if not self.derived_from_forward:
+            return {}
+
+        reaclib_rates = {r.cname(): r for r in self.reaclib_rates}
+        return {r.cname(): reaclib_rates[r.rate.cname()] for r in self.derived_rates
+                if r.rate.cname() in reaclib_rates and len(r.sets) > 1 and r.can_scale_forward()}
 
     def _rate_struct(self, n_indent, of):
         assert n_indent == 0, "function definitions must be at top level"
@@ -453,16 +898,34 @@ class BaseCxxNetwork(ABC, RateCollection):
             of.write(r.function_string_cxx(dtype=self.dtype, specifiers=self.function_specifier))
 
     def _fill_reaclib_rates(self, n_indent, of):
+        forward_rates = self._derived_forward_rates()
+        kept_rates = {f.cname() for f in forward_rates.values()}
+
         for r in self.reaclib_rates + self.derived_rates:
-            of.write(f"{self.indent*n_indent}rate_{r.cname()}<do_T_derivatives>(tfactors, rate, drate_dT);\n")
+            args = ["tfactors"]
+            if isinstance(r, DerivedRate) and r.pf_nuclei():
+                args.append("pf_cache")
+            if r.cname() in forward_rates:
+                fwd = forward_rates[r.cname()].cname()
+                args += [f"rate_fwd_{fwd}", f"drate_fwd_{fwd}_dT"]
+            args += ["rate", "drate_dT"]
+            self._write_profiled(n_indent, of,
+                                 [f"rate_{r.cname()}<do_T_derivatives>({', '.join(args)});"],
+                                 [r])
             of.write(f"{self.indent*n_indent}rate_eval.screened_rates(k_{r.cname()}) = rate;\n")
             of.write(f"{self.indent*n_indent}if constexpr (std::is_same<T, rate_derivs_t>::value) {{\n")
             of.write(f"{self.indent*n_indent}    rate_eval.dscreened_rates_dT(k_{r.cname()}) = drate_dT;\n\n")
             of.write(f"{self.indent*n_indent}}}\n")
+            if r.cname() in kept_rates:
+                # the rates derived from this one scale it by detailed balance
+                of.write(f"{self.indent*n_indent}const {self.dtype} rate_fwd_{r.cname()} = rate;\n")
+                of.write(f"{self.indent*n_indent}const {self.dtype} drate_fwd_{r.cname()}_dT = drate_dT;\n")
 
     def _fill_approx_rates(self, n_indent, of):
         for r in self.approx_rates:
-            of.write(f"{self.indent*n_indent}rate_{r.cname()}<T>(rate_eval, rate, drate_dT);\n")
+            self._write_profiled(n_indent, of,
+                                 [f"rate_{r.cname()}<T>(rate_eval, rate, drate_dT);"],
+                                 [r])
             of.write(f"{self.indent*n_indent}rate_eval.screened_rates(k_{r.cname()}) = rate;\n")
             of.write(f"{self.indent*n_indent}if constexpr (std::is_same<T, rate_derivs_t>::value) {{\n")
             of.write(f"{self.indent*n_indent}    rate_eval.dscreened_rates_dT(k_{r.cname()}) = drate_dT;\n\n")
@@ -523,6 +986,38 @@ class BaseCxxNetwork(ABC, RateCollection):
             of.write(f"{self.indent*(n_indent+1)}part_fun::interpolate_pf<part_fun::npts_{i+1}>(tfactors.T9, part_fun::temp_array_{i+1}, part_fun::{n}_pf_array, pf, dpf_dT);\n")
             of.write(f"{self.indent*(n_indent+1)}break;\n\n")
 
+    def _pf_cache_members(self, n_indent, of):
+        for n in self.get_nuclei_needing_partition_functions():
+            of.write(f"{self.indent*n_indent}Real {n}_pf, d{n}_pf_dT;\n")
+
+    def _fill_pf_cache(self, n_indent, of):
+        # the nuclei that share a temperature grid share the search
+        # for the interval of the grid holding T9
+        _, temp_indices = self.dedupe_partition_function_temperatures()
+
+        idnt = self.indent*n_indent
+
+        for k, i in enumerate(sorted(set(temp_indices.values()))):
+            if k > 0:
+                of.write("\n")
+            of.write(f"{idnt}{{\n")
+            of.write(f"{idnt}    const int idx = part_fun::find_pf_index<part_fun::npts_{i+1}>(tfactors.T9, part_fun::temp_array_{i+1});\n\n")
+            for n, j in temp_indices.items():
+                if j != i:
+                    continue
+                of.write(f"{idnt}    part_fun::interpolate_pf_at<part_fun::npts_{i+1}>(idx, tfactors.T9, part_fun::temp_array_{i+1}, part_fun::{n}_pf_array,\n")
+                of.write(f"{idnt}                                                  pf_cache.{n}_pf, pf_cache.d{n}_pf_dT);\n")
+            of.write(f"{idnt}}}\n")
+
+    def _fill_partition_function_cache(self, n_indent, of):
+        if not any(isinstance(r, DerivedRate) and r.pf_nuclei() for r in self.derived_rates):
+            return
+
+        idnt = self.indent*n_indent
+        of.write(f"{idnt}// the partition functions the derived rates need\n\n")
+        of.write(f"{idnt}pf_cache_t pf_cache;\n")
+        of.write(f"{idnt}fill_partition_function_cache(tfactors, pf_cache);\n\n")
+
     def _fill_spin_state_cases(self, n_indent, of):
 
         def key_func(nuc):
@@ -0,0 +1,281 @@
+"""Export a RateCollection as a compact binary description that a
+generic C++ engine can load at runtime, so a network can be changed
+without generating and compiling new code.
+
+The file is a sequence of named arrays:
+
+* an 8-byte magic string, ``PYNANET`` followed by a null byte
+
+* the format version and the number of arrays, as 32-bit integers
+
+* for each array: the length of its name (32-bit integer), the name,
+  a one character type code (``i`` for 32-bit integers, ``d`` for
+  64-bit floats, ``c`` for characters), the number of elements
+  (64-bit integer), and then the data
+
+all little-endian.  Arrays can be added in later versions without
+breaking older readers, which skip names they do not know.
+
+The nuclei are those of the network, followed by any intermediate
+nuclei of approximate rates and any other nuclei of the rates that
+make them up, and the rates are
+:attr:`RateCollection.all_rates`, so the rates that only enter through
+an approximate rate are included.  Indices are 0-based.
+
+"""
+
+import glob
+import os
+import shutil
+import struct
+
+import numpy as np
+
+from pynucastro.constants import constants
+from pynucastro.rates import (ApproximateRate, DerivedRate, ReacLibRate,
+                              TabularRate)
+from pynucastro.screening import get_screening_map
+
+MAGIC = b"PYNANET\0"
+VERSION = 1
+
+# the rate types
+REACLIB = 0
+DERIVED_PF = 1
+TABULAR = 2
+APPROX_AP_PG = 3
+
+_dtypes = {"i": np.dtype("<i4"), "d": np.dtype("<f8"), "c": np.dtype("S1")}
+
+
+def _joined(names):
+    return "\n".join(names).encode()
+
+
+def network_description_arrays(rc):
+    """Return the arrays describing the RateCollection rc, as a dict
+    mapping each name to a numpy array (or bytes, for the names)."""
+
+    # the rates that only make up an approximate rate can involve
+    # nuclei that are not otherwise in the network
+
+    rates = rc.all_rates
+
+    nuclei = rc.unique_nuclei + rc.approx_nuclei
+    for r in rates:
+        for n in r.reactants + r.products:
+            if n not in nuclei:
+                nuclei.append(n)
+    nuc_index = {n: i for i, n in enumerate(nuclei)}
+
+    rate_index = {r: k for k, r in enumerate(rates)}
+    in_rhs = set(rc.rates)
+
+    arrays = {}
+
+    arrays["num_spec"] = np.array([len(rc.unique_nuclei)], dtype=np.int32)
+
+    # nuclei, with their mass (as an energy, in erg) for the energy
+    # generation rate
+
+    arrays["nuclei.name"] = _joined([str(n) for n in nuclei])
+    arrays["nuclei.A"] = np.array([n.A for n in nuclei], dtype=np.int32)
+    arrays["nuclei.Z"] = np.array([n.Z for n in nuclei], dtype=np.int32)
+    arrays["nuclei.mass"] = np.array([((n.A - n.Z) * constants.m_n_MeV +
+                                       n.Z * (constants.m_p_MeV + constants.m_e_MeV) -
+                                       n.A * n.nucbind) * constants.MeV2erg
+                                      for n in nuclei])
+
+    # the rates: each contributes prefactor * rho**dens_exp [* Y_e] *
+    # rate * the product of the Y of its reactants to the RHS
+
+    rate_type = []
+    set_ptr = [0]
+    sets = []
+    table = []
+    tables = []
+    approx_rate = []
+    approx_terms = []
+
+    for k, r in enumerate(rates):
+        if isinstance(r, ApproximateRate):
+            if r.approx_type != "ap_pg":
+                raise NotImplementedError(f"approximation type {r.approx_type} not supported")
+            rate_type.append(APPROX_AP_PG)
+            # the rate is A + B * C / (D + E)
+            if not r.is_reverse:
+                terms = [r.primary_rate, r.secondary_rates[0], r.secondary_rates[1],
+                         r.secondary_rates[1], r.secondary_reverse[1]]
+            else:
+                terms = [r.primary_reverse, r.secondary_reverse[0], r.secondary_reverse[1],
+                         r.secondary_rates[1], r.secondary_reverse[1]]
+            approx_rate.append(k)
+            approx_terms += [rate_index[t] for t in terms]
+        elif isinstance(r, TabularRate):
+            rate_type.append(TABULAR)
+            table.append(len(tables))
+            tables.append(r)
+        elif isinstance(r, ReacLibRate):
+            if isinstance(r, DerivedRate) and r.use_pf:
+                rate_type.append(DERIVED_PF)
+            else:
+                rate_type.append(REACLIB)
+            for s in r.sets:
+                sets += list(s.a)
+        else:
+            raise NotImplementedError(f"rate {r} of type {type(r).__name__} is not supported")
+
+        if not isinstance(r, TabularRate):
+            table.append(-1)
+        set_ptr.append(len(sets) // 7)
+
+    arrays["rates.name"] = _joined([r.cname() for r in rates])
+    arrays["rates.type"] = np.array(rate_type, dtype=np.int32)
+    arrays["rates.in_rhs"] = np.array([r in in_rhs for r in rates], dtype=np.int32)
+    arrays["rates.prefactor"] = np.array([r.prefactor for r in rates])
+    arrays["rates.dens_exp"] = np.array([r.dens_exp for r in rates], dtype=np.int32)
+    arrays["rates.ye"] = np.array([r.weak_type == "electron_capture" and not r.tabular
+                                   for r in rates], dtype=np.int32)
+
+    for side in ("reactants", "products"):
+        ptr = [0]
+        index = []
+        for r in rates:
+            index += [nuc_index[n] for n in getattr(r, side)]
+            ptr.append(len(index))
+        arrays[f"rates.{side[:-1]}_ptr"] = np.array(ptr, dtype=np.int32)
+        arrays[f"rates.{side}"] = np.array(index, dtype=np.int32)
+
+    # the ReacLib sets, 7 coefficients each
+
+    arrays["rates.set_ptr"] = np.array(set_ptr, dtype=np.int32)
+    arrays["sets.a"] = np.array(sets, dtype=np.float64)
+
+    # the tabular rates refer to their table files, which are written
+    # along with the description
+
+    arrays["rates.table"] = np.array(table, dtype=np.int32)
+    arrays["tables.file"] = _joined([r.table_file for r in tables])
+    arrays["tables.header_lines"] = np.array([r.table_header_lines for r in tables], dtype=np.int32)
+    arrays["tables.rhoy_lines"] = np.array([r.table_rhoy_lines for r in tables], dtype=np.int32)
+    arrays["tables.temp_lines"] = np.array([r.table_temp_lines for r in tables], dtype=np.int32)
+
+    arrays["approx.rate"] = np.array(approx_rate, dtype=np.int32)
+    arrays["approx.terms"] = np.array(approx_terms, dtype=np.int32)
+
+    # the screening pairs, each with the rates it applies to -- a rate
+    # in more than one pair (3-alpha) gets the product of the factors
+
+    if rc.do_screening:
+        screening_map = get_screening_map(rc.get_rates(),
+                                          symmetric_screening=rc.symmetric_screening)
+    else:
+        screening_map = []
+
+    screen_ptr = [0]
+    screen_rates = []
+    for scr in screening_map:
+        screen_rates += [rate_index[r] for r in scr.rates]
+        screen_ptr.append(len(screen_rates))
+
+    arrays["screen.Z1"] = np.array([scr.n1.Z for scr in screening_map], dtype=np.float64)
+    arrays["screen.A1"] = np.array([scr.n1.A for scr in screening_map], dtype=np.float64)
+    arrays["screen.Z2"] = np.array([scr.n2.Z for scr in screening_map], dtype=np.float64)
+    arrays["screen.A2"] = np.array([scr.n2.A for scr in screening_map], dtype=np.float64)
+    arrays["screen.rate_ptr"] = np.array(screen_ptr, dtype=np.int32)
+    arrays["screen.rates"] = np.array(screen_rates, dtype=np.int32)
+
+    # the partition functions of the nuclei that need them, as
+    # log10(pf) tabulated in T9
+
+    pf_nuclei = set(rc.get_nuclei_needing_partition_functions())
+    pf_ptr = [0]
+    pf_T9 = []
+    pf_log10 = []
+    for n in nuclei:
+        if n in pf_nuclei:
+            pf_T9 += list(n.partition_function.temperature / 1.e9)
+            pf_log10 += list(np.log10(n.partition_function.partition_function))
+        pf_ptr.append(len(pf_T9))
+
+    arrays["pf.ptr"] = np.array(pf_ptr, dtype=np.int32)
+    arrays["pf.T9"] = np.array(pf_T9, dtype=np.float64)
+    arrays["pf.log10"] = np.array(pf_log10, dtype=np.float64)
+
+    return arrays
+
+
+def write_network_description(rc, filename):
+    """Write the binary description of the RateCollection rc to
+    filename, and copy the tables of any tabular rates to the same
+    directory."""
+
+    arrays = network_description_arrays(rc)
+
+    with open(filename, "wb") as f:
+        f.write(MAGIC)
+        f.write(struct.pack("<ii", VERSION, len(arrays)))
+        for name, data in arrays.items():
+            if isinstance(data, bytes):
+                code = "c"
+                raw = data
+                count = len(data)
+            else:
+                code = "i" if data.dtype.kind == "i" else "d"
+                raw = data.astype(_dtypes[code]).tobytes()
+                count = data.size
+            f.write(struct.pack("<i", len(name)))
+            f.write(name.encode())
+            f.write(code.encode())
+            f.write(struct.pack("<q", count))
+            f.write(raw)
+
+    odir = os.path.dirname(os.path.abspath(filename))
+    for r in rc.tabular_rates:
+        if os.path.dirname(os.path.abspath(r.table_path)) != odir:
+            shutil.copy(r.table_path, odir)
+
+
+def read_network_description(filename):
+    """Read a binary network description, returning a dict mapping
+    each name to a numpy array, with the names split into lists of
+    strings."""
+
+    with open(filename, "rb") as f:
+        if f.read(len(MAGIC)) != MAGIC:
+            raise ValueError(f"{filename} is not a network description")
+        version, narrays = struct.unpack("<ii", f.read(8))
+        if version > VERSION:
+            raise ValueError(f"{filename} has a newer version ({version}) than supported ({VERSION})")
+
+        arrays = {}
+        for _ in range(narrays):
+            nlen, = struct.unpack("<i", f.read(4))
+            name = f.read(nlen).decode()
+            code = f.read(1).decode()
+            count, = struct.unpack("<q", f.read(8))
+            raw = f.read(count * _dtypes[code].itemsize)
+            if code == "c":
+                arrays[name] = raw.decode().split("\n") if raw else []
+            else:
+                arrays[name] = np.frombuffer(raw, dtype=_dtypes[code]).copy()
+
+    return arrays
+
+
+def write_runtime_engine(odir=None):
+    """Write the C++ engine that evaluates the network from a
+    description (``runtime_network.H``), along with a driver and a
+    ``GNUmakefile``, to odir."""
+
+    pynucastro_dir = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+    template_pattern = os.path.join(pynucastro_dir, "templates",
+                                    "runtime-cxx-network", "*.template")
+
+    if odir is None:
+        odir = os.getcwd()
+    os.makedirs(odir, exist_ok=True)
+
+    for tfile in glob.glob(template_pattern):
+        outfile = os.path.basename(tfile).replace(".template", "")
+        shutil.copy(tfile, os.path.join(odir, outfile))
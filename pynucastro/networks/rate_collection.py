@@ -21,6 +21,8 @@ from mpl_toolkits.axes_grid1 import make_axes_locatable
 
 # Import Rate
 from pynucastro.constants import constants
+from pynucastro.networks.network_description import \
+    write_network_description
 from pynucastro.nucdata import Nucleus, PeriodicTable
 from pynucastro.rates import (ApproximateRate, DerivedRate, Library, Rate,
                               RateFileError, RatePair, TabularRate,
@@ -1236,6 +1238,13 @@ class RateCollection:
         assert self._distinguishable_rates(), "ERROR: Rates not uniquely identified by Rate.fname"
         self._write_network(*args, **kwargs)
 
+    def write_network_description(self, filename):
+        """Write a binary description of the network, for the runtime
+        C++ engine written by
+        :func:`write_runtime_engine <pynucastro.networks.network_description.write_runtime_engine>`
+        to load, instead of generating code for it."""
+        write_network_description(self, filename)
+
     def _distinguishable_rates(self):
         """Every Rate in this RateCollection should have a unique Rate.fname,
         as the network writers distinguish the rates on this basis."""
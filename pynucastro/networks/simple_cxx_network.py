@@ -2,17 +2,78 @@
 
 
 import glob
+import io
 import os
+import re
+import zlib
 
 from pynucastro.networks.base_cxx_network import BaseCxxNetwork
 
 
 class SimpleCxxNetwork(BaseCxxNetwork):
-    def __init__(self, *args, **kwargs):
+    def __init__(self, *args, flux_rhs=False, reaclib_matrix=False,
+                 mixed_precision=False, fd_jacobian=False, split_sources=0,
+                 **kwargs):
+        """In addition to the RateCollection arguments, this takes
+        flux_rhs: if True, rhs_nuc first computes the flux through each
+        rate and then sums them into the species by their
+        stoichiometry, instead of writing out each species' equation
+        in terms of the rates and abundances.
+        reaclib_matrix: if True, the ReacLib rates are evaluated from a
+        table of the coefficients of all of their sets, instead of
+        writing a function for each rate.
+        mixed_precision: if True, the rates, the sparse Jacobian and its
+        LU factors are stored as float, while the rates are evaluated
+        and the RHS is summed in double.
+        fd_jacobian: if True, jac_nuc finds the Jacobian by finite
+        differences of the rate fluxes, perturbing the species in a few
+        groups found from the sparsity pattern, instead of writing out
+        the symbolic derivatives, which is much cheaper to generate and
+        compile for large networks.
+        split_sources: if a number n > 0, the ReacLib rate functions,
+        rhs_nuc and jac_nuc are written to n source files each, instead
+        of the headers, so they can be compiled in parallel.  Each rate
+        and nucleus is assigned to a file by a hash of its name, so
+        changing a few rates only changes a few files."""
+
+        # this decides which templates are used, so it is needed
+        # before the parent class is initialized
+        self.split_sources = split_sources
 
         # Initialize BaseCxxNetwork parent class
         super().__init__(*args, **kwargs)
 
+        self.flux_rhs = flux_rhs
+        self.reaclib_matrix = reaclib_matrix
+        self.mixed_precision = mixed_precision
+        self.fd_jacobian = fd_jacobian
+
+        # the ReacLib sets are floored at exp(ln_floor) to avoid
+        # underflows -- with float rates, this keeps them normal floats
+        self.ln_floor = -87.0 if mixed_precision else -230.0
+
+        self.ftags['<reaclib_rate_functions_simd>'] = self._reaclib_rate_functions_simd
+        self.ftags['<fill_reaclib_rates_simd>'] = self._fill_reaclib_rates_simd
+        self.ftags['<jac_sparsity>'] = self._jac_sparsity
+        self.ftags['<jacnuc>'] = self._jacnuc
+        self.ftags['<jacnuc_sparse>'] = self._jacnuc_sparse
+        self.ftags['<jac_coloring>'] = self._jac_coloring
+        self.ftags['<lu_sparsity>'] = self._lu_sparsity
+        self.ftags['<lu_build>'] = self._lu_build
+        self.ftags['<lu_factor>'] = self._lu_factor
+        self.ftags['<lu_solve>'] = self._lu_solve
+        self.ftags['<ydot>'] = self._ydot
+        self.ftags['<rate_fluxes>'] = self._rate_fluxes
+        self.ftags['<ydot_fluxes>'] = self._ydot_fluxes
+        self.ftags['<rate_table_rates>'] = self._rate_table_rates
+        self.ftags['<reaclib_matrix>'] = self._reaclib_matrix
+        self.ftags['<rate_real>'] = self._rate_real
+        self.ftags['<split_sources_include>'] = self._split_sources_include
+        self.ftags['<chunk_declarations>'] = self._chunk_declarations
+        self.ftags['<rhs_chunk_calls>'] = self._rhs_chunk_calls
+        self.ftags['<jac_chunk_calls>'] = self._jac_chunk_calls
+        self.ftags['<jac_sparse_chunk_calls>'] = self._jac_sparse_chunk_calls
+
         self.function_specifier = "inline"
         self.dtype = "Real"
 
@@ -23,7 +84,628 @@ class SimpleCxxNetwork(BaseCxxNetwork):
                                         'simple-cxx-network',
                                         '*.template')
 
-        return glob.glob(template_pattern)
+        templates = glob.glob(template_pattern)
+
+        if not self.split_sources:
+            templates = [t for t in templates
+                         if os.path.basename(t) != "network_chunks.H.template"]
+
+        return templates
+
+    def compose_jacobian(self):
+        if not self.fd_jacobian:
+            super().compose_jacobian()
+            return
+
+        # the finite difference Jacobian only needs the sparsity
+        # pattern, which we find from the rates directly instead of
+        # differentiating the symbolic RHS: d(ydot_j)/dY_i can be nonzero
+        # if a rate changes the amount of j and has i as a reactant
+        jac_null = []
+        for nj in self.unique_nuclei:
+            for ni in self.unique_nuclei:
+                rsym_is_null = True
+                for r in self.nuclei_consumed[nj] + self.nuclei_produced[nj]:
+                    if ni in r.reactants and r.products.count(nj) != r.reactants.count(nj):
+                        rsym_is_null = False
+                        break
+                jac_null.append(rsym_is_null)
+
+        self.jac_out_result = None
+        self.jac_null_entries = jac_null
+        self.solved_jacobian = True
+        self.jac_cse = None
+
+    def _rate_real(self, n_indent, of):
+        rate_real = "float" if self.mixed_precision else "double"
+        of.write(f"{self.indent*n_indent}using RateReal = {rate_real};\n")
+
+    def _rate_struct(self, n_indent, of):
+        assert n_indent == 0, "function definitions must be at top level"
+
+        of.write("struct rate_t {\n")
+        of.write("    Array1D<RateReal, 1, NumRates>  screened_rates;\n")
+        of.write("    Real enuc_weak;\n")
+        of.write("};\n\n")
+        of.write("struct rate_derivs_t {\n")
+        of.write("    Array1D<RateReal, 1, NumRates>  screened_rates;\n")
+        of.write("    Array1D<RateReal, 1, NumRates>  dscreened_rates_dT;\n")
+        of.write("    Real enuc_weak;\n")
+        of.write("};\n\n")
+
+    def _reaclib_rate_functions(self, n_indent, of):
+        assert n_indent == 0, "function definitions must be at top level"
+        if self.reaclib_matrix:
+            return
+        if self.split_sources:
+            # the definitions are in the reaclib_rates_<n>.cpp files
+            for r in self.reaclib_rates + self.derived_rates:
+                of.write("template <int do_T_derivatives>\n")
+                of.write(f"void rate_{r.cname()}(const tf_t& tfactors, {self.dtype}& rate, {self.dtype}& drate_dT);\n\n")
+            return
+        for r in self.reaclib_rates + self.derived_rates:
+            of.write(r.function_string_cxx(dtype=self.dtype, specifiers=self.function_specifier,
+                                           ln_floor=self.ln_floor))
+
+    def _reaclib_rate_functions_simd(self, n_indent, of):
+        assert n_indent == 0, "function definitions must be at top level"
+        if self.reaclib_matrix:
+            return
+        if self.split_sources:
+            for r in self.reaclib_rates + self.derived_rates:
+                of.write("template <int do_T_derivatives, int W>\n")
+                of.write(f"void rate_{r.cname()}(const tf_simd_t<W>& tfactors, vreal<W>& rate, vreal<W>& drate_dT);\n\n")
+            return
+        for r in self.reaclib_rates + self.derived_rates:
+            of.write(r.function_string_cxx_simd(specifiers=self.function_specifier,
+                                                ln_floor=self.ln_floor))
+
+    def _fill_reaclib_rates(self, n_indent, of):
+        if not self.reaclib_matrix:
+            super()._fill_reaclib_rates(n_indent, of)
+            return
+        of.write(f"{self.indent*n_indent}fill_reaclib_rates_matrix<do_T_derivatives>(tfactors, rate_eval);\n")
+
+    def _fill_reaclib_rates_simd(self, n_indent, of):
+        idnt = self.indent*n_indent
+        if self.reaclib_matrix:
+            of.write(f"{idnt}fill_reaclib_rates_matrix(tfactors, rate_eval, z);\n")
+            return
+        for r in self.reaclib_rates + self.derived_rates:
+            of.write(f"{idnt}rate_{r.cname()}<0>(tfactors, rate, drate_dT);\n")
+            of.write(f"{idnt}rate.store(&rate_eval.screened_rates[k_{r.cname()}-1][z]);\n\n")
+
+    def _ydot(self, n_indent, of):
+        if not self.flux_rhs:
+            if self.split_sources:
+                of.write(f"{self.indent*n_indent}network_chunks::rhs_nuc(state, {self.symbol_rates.name_ydot_nuc}, Y, screened_rates);\n")
+                return
+            super()._ydot(n_indent, of)
+            return
+
+        idnt = self.indent*n_indent
+        of.write(f"{idnt}Array1D<{self.dtype}, 1, NumRates> flux;\n")
+        of.write(f"{idnt}rate_fluxes(state, Y, screened_rates, flux);\n\n")
+        of.write(f"{idnt}rhs_from_fluxes(flux, {self.symbol_rates.name_ydot_nuc});\n")
+
+    def _rate_fluxes(self, n_indent, of):
+        # the flux through each rate is the same as the rate's term in
+        # the ydot of a nucleus it creates once
+        idnt = self.indent*n_indent
+        ndigits = self.symbol_rates.float_explicit_num_digits
+        temps, fluxes = self._cse([self.symbol_rates.specific_rate_symbol(r).evalf(n=ndigits)
+                                   for r in self.rates], "flux_tmp")
+        self._write_cse_temps(n_indent, of, temps)
+
+        for r, flux in zip(self.rates, fluxes):
+            of.write(f"{idnt}flux(k_{r.cname()}) = {flux};\n")
+
+        # rates that only enter through an approximate rate
+        for r in self.all_rates:
+            if r not in self.rates:
+                of.write(f"{idnt}flux(k_{r.cname()}) = 0.0_rt;\n")
+
+    def _ydot_fluxes(self, n_indent, of):
+        idnt = self.indent*n_indent
+        name = self.symbol_rates.name_ydot_nuc
+        for n in self.unique_nuclei:
+            terms = []
+            for r, c in self._flux_stoichiometry(n):
+                if c == 1:
+                    terms.append(f"flux(k_{r.cname()})")
+                elif c == -1:
+                    terms.append(f"-flux(k_{r.cname()})")
+                else:
+                    terms.append(f"{c}.0_rt * flux(k_{r.cname()})")
+
+            if not terms:
+                of.write(f"{idnt}{name}({n.cindex()}) = 0.0_rt;\n\n")
+                continue
+
+            joined = f" +\n{idnt}{self.indent}".join(terms)
+            of.write(f"{idnt}{name}({n.cindex()}) =\n{idnt}{self.indent}{joined};\n\n")
+
+    def _rate_table_rates(self, n_indent, of):
+        # the rates set by fill_reaclib_rates, which depend only on T
+        idnt = self.indent*n_indent
+        tabulated = [f"Rates::k_{r.cname()}" for r in self.reaclib_rates + self.derived_rates]
+        of.write(f"{idnt}constexpr int NumTabulated = {len(tabulated)};\n\n")
+        # avoid a zero-length array
+        size = "NumTabulated" if tabulated else "1"
+        self._write_int_array(n_indent, of, "rates", size, tabulated or ["0"], per_line=3)
+
+    def _reaclib_matrix(self, n_indent, of):
+        idnt = self.indent*n_indent
+        rates = self.reaclib_rates + self.derived_rates
+
+        if self.reaclib_matrix:
+            for r in rates:
+                if getattr(r, "use_pf", False):
+                    raise NotImplementedError("partition functions are not supported with reaclib_matrix")
+
+        sets = [s for r in rates for s in r.sets]
+        set_start = [0]
+        for r in rates:
+            set_start.append(set_start[-1] + len(r.sets))
+
+        # pad to the widest SIMD width, with at least one column
+        width = 8
+        npadded = max(width, -(-len(sets) // width) * width)
+
+        of.write(f"{idnt}constexpr int NumSets = {len(sets)};\n")
+        of.write(f"{idnt}constexpr int NumSetsPadded = {npadded};\n")
+        of.write(f"{idnt}constexpr int NumFitRates = {len(rates)};\n\n")
+
+        of.write(f"{idnt}// each set is floored at exp(ln_floor) to avoid underflows\n")
+        of.write(f"{idnt}constexpr Real ln_floor = {self.ln_floor};\n\n")
+
+        of.write(f"{idnt}alignas(64) constexpr Real a[7][NumSetsPadded] = {{\n")
+        per_line = 4
+        for i in range(7):
+            coeffs = [f"{float(s.a[i])!r}" for s in sets] + ["0.0"] * (npadded - len(sets))
+            of.write(f"{idnt}{self.indent}{{\n")
+            for j in range(0, npadded, per_line):
+                line = ", ".join(coeffs[j:j+per_line])
+                sep = "," if j + per_line < npadded else ""
+                of.write(f"{idnt}{self.indent*2}{line}{sep}\n")
+            sep = "," if i < 6 else ""
+            of.write(f"{idnt}{self.indent}}}{sep}\n")
+        of.write(f"{idnt}}};\n\n")
+
+        self._write_int_array(n_indent, of, "rate_index", "NumFitRates" if rates else "1",
+                              [f"Rates::k_{r.cname()}" for r in rates] or ["0"], per_line=3)
+        self._write_int_array(n_indent, of, "set_start", "NumFitRates+1", set_start)
+
+    def _write_int_array(self, n_indent, of, name, size, values, per_line=12):
+        idnt = self.indent*n_indent
+        of.write(f"{idnt}constexpr int {name}[{size}] = {{\n")
+        for i in range(0, len(values), per_line):
+            line = ", ".join(f"{v}" for v in values[i:i+per_line])
+            sep = "," if i + per_line < len(values) else ""
+            of.write(f"{idnt}{self.indent}{line}{sep}\n")
+        of.write(f"{idnt}}};\n\n")
+
+    def _jac_sparsity(self, n_indent, of):
+        row_ptr, col_index = self.get_jacobian_sparsity()
+        nnz = len(col_index)
+        n_unique_nuclei = len(self.unique_nuclei)
+
+        # the same entries ordered by column, and where each one is
+        # stored in the CSR data
+        csc_entries = sorted(((col_index[k], irow, k)
+                              for irow in range(n_unique_nuclei)
+                              for k in range(row_ptr[irow], row_ptr[irow+1])))
+
+        csc_col_ptr = [0]*(n_unique_nuclei+1)
+        for jcol, _, _ in csc_entries:
+            csc_col_ptr[jcol+1] += 1
+        for jcol in range(n_unique_nuclei):
+            csc_col_ptr[jcol+1] += csc_col_ptr[jcol]
+
+        idnt = self.indent*n_indent
+        of.write(f"{idnt}constexpr int nnz = {nnz};\n\n")
+
+        of.write(f"{idnt}// CSR: the entries of row i are at [row_ptr[i-1], row_ptr[i])\n")
+        self._write_int_array(n_indent, of, "row_ptr", "NumSpec+1", row_ptr)
+        self._write_int_array(n_indent, of, "col_index", "nnz", [j + 1 for j in col_index])
+
+        of.write(f"{idnt}// CSC: the entries of column j are at [csc_col_ptr[j-1], csc_col_ptr[j])\n")
+        of.write(f"{idnt}// and csc_to_csr gives their location in the CSR data\n")
+        self._write_int_array(n_indent, of, "csc_col_ptr", "NumSpec+1", csc_col_ptr)
+        self._write_int_array(n_indent, of, "csc_row_index", "nnz", [i + 1 for _, i, _ in csc_entries])
+        self._write_int_array(n_indent, of, "csc_to_csr", "nnz", [k for _, _, k in csc_entries])
+
+    def get_jacobian_coloring(self):
+        """Partition the species into groups (colors) such that no rate
+        has two reactants of the same color, for the finite difference
+        Jacobian.  Perturbing every species of a color then changes the
+        flux through each rate because of only one of its reactants
+        (the Curtis, Powell & Reid 1974 coloring of d flux / dY, which
+        unlike the coloring of the Jacobian itself is not defeated by
+        the dense rows of the light nuclei).  This returns a list of
+        the groups, each a list of 0-based species indices.  The
+        coloring is greedy, taking the species in the most rates
+        first."""
+
+        n_unique_nuclei = len(self.unique_nuclei)
+        index = {n: i for i, n in enumerate(self.unique_nuclei)}
+
+        neighbors = [set() for _ in range(n_unique_nuclei)]
+        for r in self.rates:
+            reactants = {index[n] for n in r.reactants}
+            for i in reactants:
+                neighbors[i] |= reactants - {i}
+
+        colors = []
+        color_of = {}
+        for i in sorted(range(n_unique_nuclei), key=lambda i: -len(neighbors[i])):
+            used = {color_of[j] for j in neighbors[i] if j in color_of}
+            c = next(c for c in range(len(colors) + 1) if c not in used)
+            if c == len(colors):
+                colors.append([])
+            colors[c].append(i)
+            color_of[i] = c
+
+        return [sorted(species) for species in colors]
+
+    def _flux_stoichiometry(self, n):
+        """the rates that change the amount of nucleus n, with the net
+        number of n that each makes, as summed by rhs_from_fluxes"""
+        terms = []
+        for rp in self.nuclei_rate_pairs[n]:
+            for r in (rp.forward, rp.reverse):
+                if r is None:
+                    continue
+                c = r.products.count(n) - r.reactants.count(n)
+                if c != 0:
+                    terms.append((r, c))
+        return terms
+
+    def _jac_coloring(self, n_indent, of):
+        colors = self.get_jacobian_coloring()
+        row_ptr, col_index = self.get_jacobian_sparsity()
+
+        n_unique_nuclei = len(self.unique_nuclei)
+        index = {n: i for i, n in enumerate(self.unique_nuclei)}
+        rate_index = {r: k + 1 for k, r in enumerate(self.all_rates)}
+
+        csr = {}
+        for irow in range(n_unique_nuclei):
+            for k in range(row_ptr[irow], row_ptr[irow+1]):
+                csr[irow, col_index[k]] = k
+
+        stoich = {}
+        for n in self.unique_nuclei:
+            for r, c in self._flux_stoichiometry(n):
+                stoich.setdefault(r, []).append((index[n], c))
+
+        # for each color, the rates with a reactant of that color, and
+        # the Jacobian entries that a change in their flux goes into
+
+        color_ptr = [0]
+        rate_ptr = [0]
+        species = []
+        rates = []
+        reactants = []
+        entry_ptr = [0]
+        entry_csr = []
+        entry_stoich = []
+        for cols in colors:
+            species += cols
+            color_ptr.append(len(species))
+            for r in self.rates:
+                for jcol in sorted({index[n] for n in r.reactants} & set(cols)):
+                    rates.append(rate_index[r])
+                    reactants.append(jcol + 1)
+                    for irow, c in stoich.get(r, []):
+                        entry_csr.append(csr[irow, jcol])
+                        entry_stoich.append(c)
+                    entry_ptr.append(len(entry_csr))
+            rate_ptr.append(len(rates))
+
+        idnt = self.indent*n_indent
+        of.write(f"{idnt}constexpr int NumColors = {len(colors)};\n")
+        of.write(f"{idnt}constexpr int NumFluxDerivs = {len(rates)};\n")
+        of.write(f"{idnt}constexpr int NumEntries = {len(entry_csr)};\n\n")
+
+        of.write(f"{idnt}// the species of color c are species[color_ptr[c]:color_ptr[c+1]]\n")
+        self._write_int_array(n_indent, of, "color_ptr", "NumColors+1", color_ptr)
+        self._write_int_array(n_indent, of, "species", "NumSpec", [j + 1 for j in species])
+
+        of.write(f"{idnt}// the rates with a reactant of color c are rate[rate_ptr[c]:rate_ptr[c+1]],\n")
+        of.write(f"{idnt}// and that reactant is reactant[m]\n")
+        self._write_int_array(n_indent, of, "rate_ptr", "NumColors+1", rate_ptr)
+        self._write_int_array(n_indent, of, "rate", "NumFluxDerivs", rates)
+        self._write_int_array(n_indent, of, "reactant", "NumFluxDerivs", reactants)
+
+        of.write(f"{idnt}// the change in the flux of rate[m] goes into the Jacobian entries\n")
+        of.write(f"{idnt}// at entry_csr[entry_ptr[m]:entry_ptr[m+1]] in the CSR data, times\n")
+        of.write(f"{idnt}// the net number of the species of that row the rate makes\n")
+        self._write_int_array(n_indent, of, "entry_ptr", "NumFluxDerivs+1", entry_ptr)
+        self._write_int_array(n_indent, of, "entry_csr", "NumEntries", entry_csr)
+        self._write_int_array(n_indent, of, "entry_stoich", "NumEntries", entry_stoich)
+
+    def _jacnuc(self, n_indent, of):
+        if self.fd_jacobian:
+            of.write(f"{self.indent*n_indent}jac_nuc_fd(state, jac, Y, screened_rates);\n")
+            return
+        if self.split_sources:
+            of.write(f"{self.indent*n_indent}network_chunks::jac_nuc(state, jac, Y, screened_rates);\n")
+            return
+
+        super()._jacnuc(n_indent, of)
+
+    def _jacnuc_sparse(self, n_indent, of):
+        if self.fd_jacobian:
+            of.write(f"{self.indent*n_indent}jac_nuc_fd(state, jac, Y, screened_rates);\n")
+            return
+        if self.split_sources:
+            of.write(f"{self.indent*n_indent}network_chunks::jac_nuc(state, jac, Y, screened_rates);\n")
+            return
+
+        temps, entries = self.get_jacobian_cse()
+        self._write_jacnuc_sparse(n_indent, of, range(len(self.unique_nuclei)), temps, entries)
+
+    def _write_jacnuc_sparse(self, n_indent, of, rows, temps, entries):
+        # the same entries as _jacnuc, but written to their location in the
+        # CSR data
+        self._write_cse_temps(n_indent, of, temps)
+
+        idnt = self.indent*n_indent
+        n_unique_nuclei = len(self.unique_nuclei)
+        row_ptr, _ = self.get_jacobian_sparsity()
+        for jnj in rows:
+            nj = self.unique_nuclei[jnj]
+            k = row_ptr[jnj]
+            for ini, ni in enumerate(self.unique_nuclei):
+                jac_idx = n_unique_nuclei*jnj + ini
+                if not self.jac_null_entries[jac_idx]:
+                    jvalue = entries[jac_idx]
+                    of.write(f"{idnt}// ({nj.cindex()}, {ni.cindex()})\n")
+                    of.write(f"{idnt}jac.data[{k}] = {jvalue};\n\n")
+                    k += 1
+
+    def _split_sources_include(self, n_indent, of):
+        if self.split_sources:
+            of.write(f"{self.indent*n_indent}#include <network_chunks.H>\n")
+
+    def _source_chunk(self, name):
+        """Return the source file (of split_sources) that the rate or
+        nucleus named name is written to.  This is a hash of the name,
+        rather than its position, so it does not change when other
+        rates or nuclei are added or removed."""
+        return zlib.crc32(name.encode()) % self.split_sources
+
+    def _split_kinds(self):
+        """Return the kinds of source files written with split_sources --
+        the others are not generated code in the other modes."""
+        if not self.split_sources:
+            return []
+        kinds = []
+        if not self.reaclib_matrix:
+            kinds.append("reaclib_rates")
+        if not self.flux_rhs:
+            kinds.append("rhs_nuc")
+        if not self.fd_jacobian:
+            kinds.append("jac_nuc")
+        return kinds
+
+    def _chunk_nuclei(self, k):
+        return [n for n in self.unique_nuclei if self._source_chunk(n.short_spec_name) == k]
+
+    def _chunk_declarations(self, n_indent, of):
+        idnt = self.indent*n_indent
+        name = self.symbol_rates.name_ydot_nuc
+        kinds = self._split_kinds()
+        groups = []
+        if "rhs_nuc" in kinds:
+            groups.append([f"{idnt}void rhs_nuc_{k}(const zone_state_t& state, y_t& {name}, "
+                           "const y_t& Y, const rates_t& screened_rates);\n"
+                           for k in range(self.split_sources)])
+        if "jac_nuc" in kinds:
+            groups.append([f"{idnt}void jac_nuc{suffix}_{k}(const zone_state_t& state, {matrix_type}& jac, "
+                           "const y_t& Y, const rates_t& screened_rates);\n"
+                           for k in range(self.split_sources)
+                           for suffix, matrix_type in (("", "dense_jac_t"), ("_sparse", "sparse_jac_t"))])
+        of.write("\n".join("".join(g) for g in groups))
+
+    def _rhs_chunk_calls(self, n_indent, of):
+        if "rhs_nuc" not in self._split_kinds():
+            return
+        name = self.symbol_rates.name_ydot_nuc
+        for k in range(self.split_sources):
+            of.write(f"{self.indent*n_indent}rhs_nuc_{k}(zone_state, {name}, Y, screened_rates);\n")
+
+    def _jac_chunk_calls(self, n_indent, of):
+        if "jac_nuc" not in self._split_kinds():
+            return
+        for k in range(self.split_sources):
+            of.write(f"{self.indent*n_indent}jac_nuc_{k}(zone_state, jac, Y, screened_rates);\n")
+
+    def _jac_sparse_chunk_calls(self, n_indent, of):
+        if "jac_nuc" not in self._split_kinds():
+            return
+        for k in range(self.split_sources):
+            of.write(f"{self.indent*n_indent}jac_nuc_sparse_{k}(zone_state, jac, Y, screened_rates);\n")
+
+    def _write_source_chunks(self, odir):
+        """Write the reaclib_rates_<n>.cpp, rhs_nuc_<n>.cpp and
+        jac_nuc_<n>.cpp files for split_sources, and remove any left
+        over from writing the network with more of them."""
+
+        nchunks = self.split_sources
+        kinds = self._split_kinds()
+
+        for f in os.listdir(odir):
+            m = re.fullmatch(r"(reaclib_rates|rhs_nuc|jac_nuc)_(\d+)\.cpp", f)
+            if m and (m.group(1) not in kinds or int(m.group(2)) >= nchunks):
+                os.remove(os.path.join(odir, f))
+
+        name_ydot = self.symbol_rates.name_ydot_nuc
+
+        for k in range(nchunks if kinds else 0):
+
+            nuclei = self._chunk_nuclei(k)
+            rows = [self.unique_nuclei.index(n) for n in nuclei]
+            chunk_names = ", ".join(n.short_spec_name.capitalize() for n in nuclei) or "none"
+
+            # the rate functions, with the instantiations used by
+            # fill_reaclib_rates and fill_reaclib_rates_batch
+
+            if "reaclib_rates" in kinds:
+                of = io.StringIO()
+                of.write(f"// the ReacLib rates in group {k} of {nchunks}\n\n")
+                # only what the rate functions need, since reaclib_rates.H
+                # includes every rate's coefficients through reaclib_matrix.H
+                of.write("#include <algorithm>\n")
+                of.write("#include <cmath>\n\n")
+                of.write("#include <tfactors.H>\n\n")
+                rates = [r for r in self.reaclib_rates + self.derived_rates
+                         if self._source_chunk(r.cname()) == k]
+                for r in rates:
+                    of.write(r.function_string_cxx(dtype=self.dtype, specifiers="",
+                                                   ln_floor=self.ln_floor))
+                    of.write(r.function_string_cxx_simd(specifiers="", ln_floor=self.ln_floor))
+                for r in rates:
+                    for do_T_derivatives in (0, 1):
+                        of.write(f"template void rate_{r.cname()}<{do_T_derivatives}>"
+                                 f"(const tf_t& tfactors, {self.dtype}& rate, {self.dtype}& drate_dT);\n")
+                    of.write(f"template void rate_{r.cname()}<0, simd::native_width>"
+                             "(const tf_simd_t<simd::native_width>& tfactors, "
+                             "vreal<simd::native_width>& rate, vreal<simd::native_width>& drate_dT);\n\n")
+                self._write_if_changed(os.path.join(odir, f"reaclib_rates_{k}.cpp"), of.getvalue())
+
+            # the RHS of the species in this group
+
+            if "rhs_nuc" in kinds:
+                of = io.StringIO()
+                of.write(f"// the RHS in group {k} of {nchunks}, for the species: {chunk_names}\n\n")
+                self._write_chunk_preamble(of)
+                self._write_chunk_signature(of, f"rhs_nuc_{k}", f"y_t& {name_ydot}")
+                temps, terms = self.get_ydot_cse(nuclei)
+                self._write_ydot(1, of, nuclei, temps, terms)
+                of.write("}\n\n}\n")
+                self._write_if_changed(os.path.join(odir, f"rhs_nuc_{k}.cpp"), of.getvalue())
+
+            # the rows of the Jacobian of the species in this group,
+            # for both a dense and a sparse matrix
+
+            if "jac_nuc" in kinds:
+                of = io.StringIO()
+                of.write(f"// the Jacobian in group {k} of {nchunks}, for the rows of: {chunk_names}\n\n")
+                self._write_chunk_preamble(of)
+                temps, entries = self.get_jacobian_cse(rows)
+                self._write_chunk_signature(of, f"jac_nuc_{k}", "dense_jac_t& jac")
+                of.write(f"{self.indent}[[maybe_unused]] {self.dtype} scratch;\n\n")
+                self._write_jacnuc(1, of, rows, temps, entries)
+                of.write("}\n\n")
+                self._write_chunk_signature(of, f"jac_nuc_sparse_{k}", "sparse_jac_t& jac")
+                self._write_jacnuc_sparse(1, of, rows, temps, entries)
+                of.write("}\n\n}\n")
+                self._write_if_changed(os.path.join(odir, f"jac_nuc_{k}.cpp"), of.getvalue())
+
+    @staticmethod
+    def _write_chunk_preamble(of):
+        of.write("#include <network_chunks.H>\n\n")
+        of.write("using namespace Rates;\n")
+        of.write("using namespace Species;\n\n")
+        of.write("namespace network_chunks\n{\n\n")
+
+    @staticmethod
+    def _write_chunk_signature(of, name, output):
+        # a group can be empty, or not need every argument
+        of.write(f"void {name}([[maybe_unused]] const zone_state_t& state,\n")
+        for arg in (output, "const y_t& Y", "const rates_t& screened_rates"):
+            sep = ")" if arg.endswith("screened_rates") else ","
+            of.write(f"{' ' * (len(name) + 6)}[[maybe_unused]] {arg}{sep}\n")
+        of.write("{\n\n")
+
+    def _lu_positions(self):
+        """return a dict mapping (row, col) to the location in the LU data"""
+        row_ptr, col_index = self.get_lu_sparsity()
+        return {(irow, col_index[m]): m
+                for irow in range(len(self.unique_nuclei))
+                for m in range(row_ptr[irow], row_ptr[irow+1])}
+
+    def _gpu_qualifiers_include(self, n_indent, of):
+        # the AMREX_* qualifiers are defined in amrex_bridge.H here
+        of.write(f"{self.indent*n_indent}#include <amrex_bridge.H>\n")
+
+    def _lu_sparsity(self, n_indent, of):
+        row_ptr, col_index = self.get_lu_sparsity()
+        idnt = self.indent*n_indent
+        of.write(f"{idnt}constexpr int nnz = {len(col_index)};\n\n")
+
+        of.write(f"{idnt}// CSR: the entries of row i are at [row_ptr[i-1], row_ptr[i])\n")
+        self._write_int_array(n_indent, of, "row_ptr", "NumSpec+1", row_ptr)
+        self._write_int_array(n_indent, of, "col_index", "nnz", [j + 1 for j in col_index])
+
+    def _lu_build(self, n_indent, of):
+        idnt = self.indent*n_indent
+        jac_row_ptr, jac_col_index = self.get_jacobian_sparsity()
+        jac_positions = {(irow, jac_col_index[k]): k
+                         for irow in range(len(self.unique_nuclei))
+                         for k in range(jac_row_ptr[irow], jac_row_ptr[irow+1])}
+
+        for (irow, jcol), m in sorted(self._lu_positions().items(), key=lambda x: x[1]):
+            k = jac_positions.get((irow, jcol))
+            if k is None:
+                value = "1.0_rt" if irow == jcol else "0.0_rt"
+            elif irow == jcol:
+                value = f"lu_entry(1.0_rt - gamma * jac.data[{k}])"
+            else:
+                value = f"lu_entry(-gamma * jac.data[{k}])"
+            of.write(f"{idnt}lu.a[{m}] = {value};\n")
+
+    def _lu_factor(self, n_indent, of):
+        idnt = self.indent*n_indent
+        n_unique_nuclei = len(self.unique_nuclei)
+        pos = self._lu_positions()
+
+        rows = [[] for _ in range(n_unique_nuclei)]
+        cols = [[] for _ in range(n_unique_nuclei)]
+        for irow, jcol in sorted(pos):
+            rows[irow].append(jcol)
+            cols[jcol].append(irow)
+
+        for k in range(n_unique_nuclei):
+            lower = [irow for irow in cols[k] if irow > k]
+            upper = [jcol for jcol in rows[k] if jcol > k]
+
+            of.write(f"{idnt}// column {k+1}\n")
+            of.write(f"{idnt}row_max = std::abs(lu.a[{pos[k, k]}]);\n")
+            for jcol in upper:
+                of.write(f"{idnt}row_max = std::max(row_max, std::abs(lu.a[{pos[k, jcol]}]));\n")
+            of.write(f"{idnt}if (!(std::abs(lu.a[{pos[k, k]}]) > pivot_tol * row_max)) {{\n")
+            of.write(f"{idnt}{self.indent}return {k+1};\n")
+            of.write(f"{idnt}}}\n")
+            if not lower:
+                of.write("\n")
+                continue
+            of.write(f"{idnt}inv_pivot = 1.0_rt / lu.a[{pos[k, k]}];\n")
+            for irow in lower:
+                of.write(f"{idnt}lu.a[{pos[irow, k]}] *= inv_pivot;\n")
+                for jcol in upper:
+                    of.write(f"{idnt}lu.a[{pos[irow, jcol]}] -= lu.a[{pos[irow, k]}] * lu.a[{pos[k, jcol]}];\n")
+            of.write("\n")
+
+    def _lu_solve(self, n_indent, of):
+        idnt = self.indent*n_indent
+        n_unique_nuclei = len(self.unique_nuclei)
+        pos = self._lu_positions()
+
+        of.write(f"{idnt}// forward substitution with the unit lower triangle\n")
+        for irow in range(n_unique_nuclei):
+            for jcol in range(irow):
+                if (irow, jcol) in pos:
+                    of.write(f"{idnt}b({irow+1}) -= lu.a[{pos[irow, jcol]}] * b({jcol+1});\n")
+
+        of.write(f"\n{idnt}// back substitution with the upper triangle\n")
+        for irow in reversed(range(n_unique_nuclei)):
+            for jcol in range(irow+1, n_unique_nuclei):
+                if (irow, jcol) in pos:
+                    of.write(f"{idnt}b({irow+1}) -= lu.a[{pos[irow, jcol]}] * b({jcol+1});\n")
+            of.write(f"{idnt}b({irow+1}) /= lu.a[{pos[irow, irow]}];\n")
 
     def _write_network(self, odir=None):
         """
@@ -38,44 +720,48 @@ class SimpleCxxNetwork(BaseCxxNetwork):
 
         if odir is None:
             odir = os.getcwd()
+
+        self._write_source_chunks(odir)
         # create a header file with the nuclei properties
-        with open(os.path.join(odir, "network_properties.H"), "w") as of:
-            of.write("#ifndef NETWORK_PROPERTIES_H\n")
-            of.write("#define NETWORK_PROPERTIES_H\n")
-            of.write("#include <vector>\n")
-            of.write("#include <string>\n")
-            of.write("#include <amrex_bridge.H>\n\n")
-
-            of.write(f"constexpr int NumSpec = {len(self.unique_nuclei)};\n\n")
-
-            of.write("constexpr Real aion[NumSpec] = {\n")
-            for n, nuc in enumerate(self.unique_nuclei):
-                of.write(f"    {nuc.A:6.1f}, // {n}\n")
-            of.write(" };\n\n")
-
-            of.write("constexpr Real aion_inv[NumSpec] = {\n")
-            for n, nuc in enumerate(self.unique_nuclei):
-                of.write(f"    1.0/{nuc.A:6.1f}, // {n}\n")
-            of.write(" };\n\n")
-
-            of.write("constexpr Real zion[NumSpec] = {\n")
-            for n, nuc in enumerate(self.unique_nuclei):
-                of.write(f"    {nuc.Z:6.1f}, // {n}\n")
-            of.write(" };\n\n")
-
-            of.write("static const std::vector<std::string> spec_names = {\n")
-            for n, nuc in enumerate(self.unique_nuclei):
-                of.write(f"    \"{nuc.short_spec_name.capitalize()}\", // {n}\n")
-            of.write(" };\n\n")
-
-            of.write("namespace Species {\n")
-            of.write("  enum NetworkSpecies {\n")
-            for n, nuc in enumerate(self.unique_nuclei):
-                if n == 0:
-                    of.write(f"    {nuc.short_spec_name.capitalize()}=1,\n")
-                else:
-                    of.write(f"    {nuc.short_spec_name.capitalize()},\n")
-            of.write("  };\n")
-            of.write("}\n\n")
+        of = io.StringIO()
+        of.write("#ifndef NETWORK_PROPERTIES_H\n")
+        of.write("#define NETWORK_PROPERTIES_H\n")
+        of.write("#include <vector>\n")
+        of.write("#include <string>\n")
+        of.write("#include <amrex_bridge.H>\n\n")
+
+        of.write(f"constexpr int NumSpec = {len(self.unique_nuclei)};\n\n")
+
+        of.write("constexpr Real aion[NumSpec] = {\n")
+        for n, nuc in enumerate(self.unique_nuclei):
+            of.write(f"    {nuc.A:6.1f}, // {n}\n")
+        of.write(" };\n\n")
+
+        of.write("constexpr Real aion_inv[NumSpec] = {\n")
+        for n, nuc in enumerate(self.unique_nuclei):
+            of.write(f"    1.0/{nuc.A:6.1f}, // {n}\n")
+        of.write(" };\n\n")
+
+        of.write("constexpr Real zion[NumSpec] = {\n")
+        for n, nuc in enumerate(self.unique_nuclei):
+            of.write(f"    {nuc.Z:6.1f}, // {n}\n")
+        of.write(" };\n\n")
+
+        of.write("static const std::vector<std::string> spec_names = {\n")
+        for n, nuc in enumerate(self.unique_nuclei):
+            of.write(f"    \"{nuc.short_spec_name.capitalize()}\", // {n}\n")
+        of.write(" };\n\n")
+
+        of.write("namespace Species {\n")
+        of.write("  enum NetworkSpecies {\n")
+        for n, nuc in enumerate(self.unique_nuclei):
+            if n == 0:
+                of.write(f"    {nuc.short_spec_name.capitalize()}=1,\n")
+            else:
+                of.write(f"    {nuc.short_spec_name.capitalize()},\n")
+        of.write("  };\n")
+        of.write("}\n\n")
+
+        of.write("#endif\n")
 
-            of.write("#endif\n")
+        self._write_if_changed(os.path.join(odir, "network_properties.H"), of.getvalue())
@@ -1,5 +1,6 @@
 #include <AMReX_Array.H>
 #include <string>
+#include <extern_parameters.H>
 #include <table_rates.H>
 #include <AMReX_Print.H>
 
@@ -9,6 +10,7 @@ namespace rate_tables
 {
 
 
+
 }
 
 
@@ -1,5 +1,6 @@
 #include <AMReX_Array.H>
 #include <string>
+#include <extern_parameters.H>
 #include <table_rates.H>
 #include <AMReX_Print.H>
 
@@ -8,15 +9,38 @@ using namespace amrex;
 namespace rate_tables
 {
 
-    AMREX_GPU_MANAGED table_t j_Na23_Ne23_meta;
-    AMREX_GPU_MANAGED Array3D<Real, 1, 39, 1, 152, 1, 6> j_Na23_Ne23_data;
-    AMREX_GPU_MANAGED Array1D<Real, 1, 152> j_Na23_Ne23_rhoy;
-    AMREX_GPU_MANAGED Array1D<Real, 1, 39> j_Na23_Ne23_temp;
-
-    AMREX_GPU_MANAGED table_t j_Ne23_Na23_meta;
-    AMREX_GPU_MANAGED Array3D<Real, 1, 39, 1, 152, 1, 6> j_Ne23_Na23_data;
-    AMREX_GPU_MANAGED Array1D<Real, 1, 152> j_Ne23_Na23_rhoy;
-    AMREX_GPU_MANAGED Array1D<Real, 1, 39> j_Ne23_Na23_temp;
+    AMREX_GPU_MANAGED table_t table_group_1_meta;
+    AMREX_GPU_MANAGED Array3D<Real, 1, 2 * packed_vars, 1, 39, 1, 152> table_group_1_data;
+    AMREX_GPU_MANAGED Array1D<Real, 1, 152> table_group_1_rhoy;
+    AMREX_GPU_MANAGED Array1D<Real, 1, 39> table_group_1_temp;
+
+
+    std::once_flag table_group_1_loaded;
+
+    void add_table_group_1_loads(table_loads_t& loads)
+    {
+        loads.emplace_back([] () {
+            table_t meta = table_group_1_meta;
+            meta.nheader = 7;
+            auto table = packed_table(table_group_1_data, 0);
+            init_tab_info(meta, "23na-23ne_electroncapture.dat", table_group_1_rhoy, table_group_1_temp, table);
+        });
+        loads.emplace_back([] () {
+            table_t meta = table_group_1_meta;
+            meta.nheader = 5;
+            auto table = packed_table(table_group_1_data, 1);
+            Array1D<Real, 1, 152> rhoy;
+            Array1D<Real, 1, 39> temp;
+            init_tab_info(meta, "23ne-23na_betadecay.dat", rhoy, temp, table);
+        });
+    }
+
+    void load_table_group_1()
+    {
+        table_loads_t loads;
+        add_table_group_1_loads(loads);
+        load_tables(loads);
+    }
 
 
 }
@@ -29,21 +53,22 @@ void init_tabular()
 
     using namespace rate_tables;
 
-    j_Na23_Ne23_meta.ntemp = 39;
-    j_Na23_Ne23_meta.nrhoy = 152;
-    j_Na23_Ne23_meta.nvars = 6;
-    j_Na23_Ne23_meta.nheader = 7;
-
-    init_tab_info(j_Na23_Ne23_meta, "23na-23ne_electroncapture.dat", j_Na23_Ne23_rhoy, j_Na23_Ne23_temp, j_Na23_Ne23_data);
-
-
-    j_Ne23_Na23_meta.ntemp = 39;
-    j_Ne23_Na23_meta.nrhoy = 152;
-    j_Ne23_Na23_meta.nvars = 6;
-    j_Ne23_Na23_meta.nheader = 5;
+    table_group_1_meta.ntemp = 39;
+    table_group_1_meta.nrhoy = 152;
+    table_group_1_meta.nvars = 6;
+    table_group_1_meta.nheader = 0;
 
-    init_tab_info(j_Ne23_Na23_meta, "23ne-23na_betadecay.dat", j_Ne23_Na23_rhoy, j_Ne23_Na23_temp, j_Ne23_Na23_data);
+#ifndef AMREX_USE_GPU
+    if (lazy_tabular_tables) {
+        amrex::Print() << "tables will be read when they are first used" << std::endl;
+        return;
+    }
+#endif
 
+    table_loads_t loads;
+    add_table_group_1_loads(loads);
+    load_tables(loads);
 
+    std::call_once(table_group_1_loaded, [] () {});
 
 }
@@ -1,5 +1,6 @@
 #include <actual_network.H>
 #include <amrex_bridge.H>
+#include <rate_table.H>
 
 namespace network
 {
@@ -34,4 +35,11 @@ void actual_network_init()
         mion(i) = (aion[i-1] - zion[i-1]) * C::m_n + zion[i-1] * (C::m_p + C::m_e) - bion(i) * C::MeV2gr;
     }
 
+#ifdef REACLIB_RATE_TABLE
+    // tabulate the ReacLib rates, now that the network data is set
+
+    rate_table::build(REACLIB_RATE_TABLE_TMIN, REACLIB_RATE_TABLE_TMAX,
+                      REACLIB_RATE_TABLE_RTOL);
+#endif
+
 }
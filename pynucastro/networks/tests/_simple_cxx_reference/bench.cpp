@@ -0,0 +1,535 @@
+// Micro-benchmarks of the network kernels.  Each kernel is timed over a
+// sweep of (rho, T, X) states, repeated to get statistics, and the
+// results are written as a table and as JSON so they can be compared
+// between versions of the generated network.
+//
+// usage: ./bench [repetitions] [output.json]
+
+#include <amrex_bridge.H>
+#include <network_properties.H>
+#include <actual_rhs.H>
+#include <linpack.H>
+#include <sparse_lu.H>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace bench
+{
+    constexpr int nrho = 4;
+    constexpr int ntemp = 8;
+    constexpr int ncomp = 2;
+    constexpr int nstates = nrho * ntemp * ncomp;
+
+    // the states are processed in blocks of this size by the batched kernels
+
+    constexpr int nzones = 16;
+    static_assert(nstates % nzones == 0, "the sweep must be a whole number of blocks");
+
+    // minimum time for one repetition
+
+    constexpr double min_rep_time = 0.02;
+
+    // keep the compiler from optimizing away a result
+
+    template <typename T>
+    inline void do_not_optimize (const T& value) {
+#if defined(__GNUC__)
+        asm volatile("" : : "r,m"(value) : "memory");
+#else
+        static volatile T sink;
+        sink = value;
+#endif
+    }
+
+    struct result_t {
+        std::string name;
+        long calls_per_rep;
+        std::vector<double> ns_per_call;
+        double min;
+        double median;
+        double mean;
+        double stddev;
+    };
+
+    // time the kernel f(i), for i = 0 to ncalls-1.  The number of sweeps
+    // over the calls in one repetition is doubled until the repetition
+    // takes at least min_rep_time.
+
+    inline
+    result_t time_kernel (const std::string& name, const int ncalls, const int nreps,
+                          const std::function<void(int)>& f)
+    {
+        using clock = std::chrono::steady_clock;
+
+        auto run = [&] (const long nsweeps) {
+            auto start = clock::now();
+            for (long s = 0; s < nsweeps; ++s) {
+                for (int i = 0; i < ncalls; ++i) {
+                    f(i);
+                }
+            }
+            return std::chrono::duration<double>(clock::now() - start).count();
+        };
+
+        long nsweeps = 1;
+        while (run(nsweeps) < min_rep_time) {
+            nsweeps *= 2;
+        }
+
+        result_t r;
+        r.name = name;
+        r.calls_per_rep = nsweeps * ncalls;
+
+        for (int n = 0; n < nreps; ++n) {
+            r.ns_per_call.push_back(1.e9 * run(nsweeps) / static_cast<double>(r.calls_per_rep));
+        }
+
+        std::vector<double> sorted = r.ns_per_call;
+        std::sort(sorted.begin(), sorted.end());
+
+        r.min = sorted.front();
+        r.median = (nreps % 2 == 1) ? sorted[nreps / 2] :
+            0.5 * (sorted[nreps / 2 - 1] + sorted[nreps / 2]);
+
+        r.mean = 0.0;
+        for (auto t : sorted) {
+            r.mean += t;
+        }
+        r.mean /= nreps;
+
+        r.stddev = 0.0;
+        for (auto t : sorted) {
+            r.stddev += (t - r.mean) * (t - r.mean);
+        }
+        r.stddev = nreps > 1 ? std::sqrt(r.stddev / (nreps - 1)) : 0.0;
+
+        return r;
+    }
+
+    // the rates stored in Real, to check a network that stores them
+    // in a lower precision (RateReal)
+
+    struct rate_real_t {
+        Array1D<Real, 1, NumRates> screened_rates;
+        Real enuc_weak;
+    };
+
+    struct accuracy_t {
+        double rates{0.0};
+        double ydot{0.0};
+        double enuc{0.0};
+        double jac{0.0};
+
+        // the finite difference Jacobian, jac_nuc_fd, vs. jac_nuc (zero
+        // if the network was written with fd_jacobian, since then
+        // jac_nuc is jac_nuc_fd)
+
+        double jac_fd{0.0};
+    };
+
+    // the largest errors over the sweep, relative to the largest
+    // magnitude in each state for ydot and the Jacobian
+
+    inline
+    accuracy_t accuracy (const std::vector<burn_t>& states)
+    {
+        accuracy_t err;
+
+        for (auto state : states) {
+
+            Array1D<Real, 1, NumSpec> Y;
+            for (int n = 1; n <= NumSpec; ++n) {
+                Y(n) = state.xn[n-1] * aion_inv[n-1];
+            }
+
+            const tf_t tfactors = evaluate_tfactors(state.T);
+
+            rate_real_t rates_ref;
+            fill_reaclib_rates<0, rate_real_t>(tfactors, rates_ref);
+            fill_approx_rates<0, rate_real_t>(tfactors, rates_ref);
+
+            rate_t rates;
+            evaluate_rates<0, rate_t>(state, rates);
+
+            for (int k = 1; k <= NumRates; ++k) {
+                if (rates_ref.screened_rates(k) != 0.0_rt) {
+                    err.rates = std::max(err.rates, static_cast<double>(
+                        std::abs(rates.screened_rates(k) / rates_ref.screened_rates(k) - 1.0_rt)));
+                }
+            }
+
+            Array1D<Real, 1, NumSpec> ydot_ref;
+            rhs_nuc(state, ydot_ref, Y, rates_ref.screened_rates);
+
+            Array1D<Real, 1, NumSpec> ydot;
+            actual_rhs(state, ydot);
+
+            Real ydot_max{0.0};
+            Real ydot_err{0.0};
+            for (int n = 1; n <= NumSpec; ++n) {
+                ydot_max = std::max(ydot_max, std::abs(ydot_ref(n)));
+                ydot_err = std::max(ydot_err, std::abs(ydot(n) - ydot_ref(n)));
+            }
+            if (ydot_max > 0.0_rt) {
+                err.ydot = std::max(err.ydot, static_cast<double>(ydot_err / ydot_max));
+            }
+
+            Real enuc_ref;
+            Real enuc;
+            ener_gener_rate(ydot_ref, enuc_ref);
+            ener_gener_rate(ydot, enuc);
+            if (enuc_ref != 0.0_rt) {
+                err.enuc = std::max(err.enuc, static_cast<double>(std::abs(enuc / enuc_ref - 1.0_rt)));
+            }
+
+            MathArray2D<1, NumSpec, 1, NumSpec> jac_ref;
+            jac_ref.zero();
+            jac_nuc(state, jac_ref, Y, rates_ref.screened_rates);
+
+            sparse_jac_t jac;
+            actual_jac(state, jac);
+
+            Real jac_max{0.0};
+            Real jac_err{0.0};
+            for (int j = 1; j <= NumSpec; ++j) {
+                for (int i = 1; i <= NumSpec; ++i) {
+                    jac_max = std::max(jac_max, std::abs(jac_ref(i,j)));
+                    jac_err = std::max(jac_err, std::abs(jac.get(i,j) - jac_ref(i,j)));
+                }
+            }
+            if (jac_max > 0.0_rt) {
+                err.jac = std::max(err.jac, static_cast<double>(jac_err / jac_max));
+            }
+
+            MathArray2D<1, NumSpec, 1, NumSpec> jac_fd;
+            jac_fd.zero();
+            jac_nuc_fd(state, jac_fd, Y, rates_ref.screened_rates);
+
+            Real jac_fd_err{0.0};
+            for (int j = 1; j <= NumSpec; ++j) {
+                for (int i = 1; i <= NumSpec; ++i) {
+                    jac_fd_err = std::max(jac_fd_err, std::abs(jac_fd(i,j) - jac_ref(i,j)));
+                }
+            }
+            if (jac_max > 0.0_rt) {
+                err.jac_fd = std::max(err.jac_fd, static_cast<double>(jac_fd_err / jac_max));
+            }
+        }
+
+        return err;
+    }
+}
+
+
+int main(int argc, char* argv[]) {
+
+    using namespace bench;
+
+    int nreps = argc > 1 ? std::atoi(argv[1]) : 15;
+    std::string json_file = argc > 2 ? argv[2] : "bench.json";
+
+    if (nreps < 1) {
+        std::cerr << "the number of repetitions must be positive" << std::endl;
+        return 1;
+    }
+
+    actual_network_init();
+
+    // the sweep of thermodynamic states: log-spaced density and
+    // temperature, and a uniform and a random composition
+
+    std::vector<burn_t> states(nstates);
+
+    std::mt19937 gen(12345);
+    std::uniform_real_distribution<Real> dist(0.0_rt, 1.0_rt);
+
+    Real xn_random[NumSpec];
+    Real sum = 0.0_rt;
+    for (int n = 0; n < NumSpec; ++n) {
+        xn_random[n] = dist(gen);
+        sum += xn_random[n];
+    }
+
+    int i = 0;
+    for (int ic = 0; ic < ncomp; ++ic) {
+        for (int ir = 0; ir < nrho; ++ir) {
+            for (int it = 0; it < ntemp; ++it) {
+                burn_t& state = states[i++];
+                state.rho = std::pow(10.0_rt, 2.0_rt + 7.0_rt * ir / (nrho - 1));
+                state.T = std::pow(10.0_rt, 8.0_rt + 1.7_rt * it / (ntemp - 1));
+                for (int n = 0; n < NumSpec; ++n) {
+                    state.xn[n] = ic == 0 ? 1.0_rt / static_cast<Real>(NumSpec) : xn_random[n] / sum;
+                }
+            }
+        }
+    }
+
+    // the inputs to the individual kernels
+
+    std::vector<tf_t> tfactors(nstates);
+    std::vector<rate_t> rates(nstates);
+    std::vector<Array1D<Real, 1, NumSpec>> Y(nstates);
+
+    for (int s = 0; s < nstates; ++s) {
+        tfactors[s] = evaluate_tfactors(states[s].T);
+        evaluate_rates<0, rate_t>(states[s], rates[s]);
+        for (int n = 1; n <= NumSpec; ++n) {
+            Y[s](n) = states[s].xn[n-1] * aion_inv[n-1];
+        }
+    }
+
+    std::vector<burn_batch_t<nzones>> blocks(nstates / nzones);
+
+    for (int s = 0; s < nstates; ++s) {
+        auto& b = blocks[s / nzones];
+        b.rho[s % nzones] = states[s].rho;
+        b.T[s % nzones] = states[s].T;
+        for (int n = 0; n < NumSpec; ++n) {
+            b.xn[n][s % nzones] = states[s].xn[n];
+        }
+    }
+
+    // the outputs
+
+    rate_t rate_eval;
+    rate_derivs_t rate_derivs_eval;
+    rate_batch_t<nzones> rate_batch;
+    Array1D<Real, 1, NumSpec> ydot;
+    MathArray2D<1, NumSpec, 1, NumSpec> jac;
+    sparse_jac_t sparse_jac;
+    static Real ydot_batch[NumSpec][nzones];
+    static Real jac_batch[NumSpec*NumSpec][nzones];
+
+    std::vector<result_t> results;
+
+    results.push_back(time_kernel("evaluate_tfactors", nstates, nreps, [&] (int s) {
+        tf_t tf = evaluate_tfactors(states[s].T);
+        do_not_optimize(tf);
+    }));
+
+    results.push_back(time_kernel("fill_reaclib_rates<0>", nstates, nreps, [&] (int s) {
+        fill_reaclib_rates<0, rate_t>(tfactors[s], rate_eval);
+        do_not_optimize(rate_eval);
+    }));
+
+    results.push_back(time_kernel("fill_reaclib_rates<1>", nstates, nreps, [&] (int s) {
+        fill_reaclib_rates<1, rate_derivs_t>(tfactors[s], rate_derivs_eval);
+        do_not_optimize(rate_derivs_eval);
+    }));
+
+    results.push_back(time_kernel("rhs_nuc", nstates, nreps, [&] (int s) {
+        for (int n = 1; n <= NumSpec; ++n) {
+            ydot(n) = 0.0_rt;
+        }
+        rhs_nuc(states[s], ydot, Y[s], rates[s].screened_rates);
+        do_not_optimize(ydot);
+    }));
+
+    results.push_back(time_kernel("jac_nuc", nstates, nreps, [&] (int s) {
+        jac.zero();
+        jac_nuc(states[s], jac, Y[s], rates[s].screened_rates);
+        do_not_optimize(jac);
+    }));
+
+    results.push_back(time_kernel("jac_nuc (sparse)", nstates, nreps, [&] (int s) {
+        jac_nuc(states[s], sparse_jac, Y[s], rates[s].screened_rates);
+        do_not_optimize(sparse_jac);
+    }));
+
+    results.push_back(time_kernel("jac_nuc_fd (sparse)", nstates, nreps, [&] (int s) {
+        jac_nuc_fd(states[s], sparse_jac, Y[s], rates[s].screened_rates);
+        do_not_optimize(sparse_jac);
+    }));
+
+    results.push_back(time_kernel("actual_rhs", nstates, nreps, [&] (int s) {
+        actual_rhs(states[s], ydot);
+        do_not_optimize(ydot);
+    }));
+
+    results.push_back(time_kernel("actual_jac", nstates, nreps, [&] (int s) {
+        actual_jac(states[s], jac);
+        do_not_optimize(jac);
+    }));
+
+    results.push_back(time_kernel("actual_jac (sparse)", nstates, nreps, [&] (int s) {
+        actual_jac(states[s], sparse_jac);
+        do_not_optimize(sparse_jac);
+    }));
+
+    results.push_back(time_kernel("actual_rhs_and_jac (sparse)", nstates, nreps, [&] (int s) {
+        actual_rhs_and_jac(states[s], ydot, sparse_jac);
+        do_not_optimize(ydot);
+        do_not_optimize(sparse_jac);
+    }));
+
+    // the linear algebra for the implicit integrator, factoring and
+    // solving I - gamma J
+
+    constexpr Real gamma = 1.e-8_rt;
+
+    std::vector<sparse_jac_t> sparse_jacs(nstates);
+    for (int s = 0; s < nstates; ++s) {
+        actual_jac(states[s], sparse_jacs[s]);
+    }
+
+    MathArray2D<1, NumSpec, 1, NumSpec> dense_lu;
+    Array1D<int, 1, NumSpec> pivot;
+    sparse_lu_t sparse_lu;
+    Array1D<Real, 1, NumSpec> b;
+
+    results.push_back(time_kernel("dgefa", nstates, nreps, [&] (int s) {
+        sparse_jacs[s].to_dense(dense_lu);
+        for (int j = 1; j <= NumSpec; ++j) {
+            for (int i = 1; i <= NumSpec; ++i) {
+                dense_lu(i,j) *= -gamma;
+            }
+            dense_lu(j,j) += 1.0_rt;
+        }
+        int info;
+        dgefa(dense_lu, pivot, info);
+        do_not_optimize(dense_lu);
+    }));
+
+    results.push_back(time_kernel("dgesl", nstates, nreps, [&] (int s) {
+        for (int n = 1; n <= NumSpec; ++n) {
+            b(n) = Y[s](n);
+        }
+        dgesl(dense_lu, pivot, b);
+        do_not_optimize(b);
+    }));
+
+    results.push_back(time_kernel("sparse_lu_factor", nstates, nreps, [&] (int s) {
+        sparse_lu_build(sparse_jacs[s], gamma, sparse_lu);
+        int info = sparse_lu_factor(sparse_lu);
+        do_not_optimize(info);
+        do_not_optimize(sparse_lu);
+    }));
+
+    results.push_back(time_kernel("sparse_lu_solve", nstates, nreps, [&] (int s) {
+        for (int n = 1; n <= NumSpec; ++n) {
+            b(n) = Y[s](n);
+        }
+        sparse_lu_solve(sparse_lu, b);
+        do_not_optimize(b);
+    }));
+
+    // the batched kernels are reported per zone
+
+    const int nblocks = nstates / nzones;
+
+    auto per_zone = [&] (result_t r) {
+        r.calls_per_rep *= nzones;
+        for (auto& t : r.ns_per_call) {
+            t /= nzones;
+        }
+        r.min /= nzones;
+        r.median /= nzones;
+        r.mean /= nzones;
+        r.stddev /= nzones;
+        return r;
+    };
+
+    results.push_back(per_zone(time_kernel("fill_reaclib_rates_batch", nblocks, nreps, [&] (int b) {
+        fill_reaclib_rates_batch<nzones>(blocks[b].T, rate_batch);
+        do_not_optimize(rate_batch);
+    })));
+
+    results.push_back(per_zone(time_kernel("actual_rhs_batch", nblocks, nreps, [&] (int b) {
+        actual_rhs_batch(blocks[b], ydot_batch);
+        do_not_optimize(ydot_batch);
+    })));
+
+    results.push_back(per_zone(time_kernel("actual_jac_batch", nblocks, nreps, [&] (int b) {
+        actual_jac_batch(blocks[b], jac_batch);
+        do_not_optimize(jac_batch);
+    })));
+
+    // the accuracy of the rate storage precision, compared to
+    // storing the rates in Real
+
+    const std::string rate_precision = sizeof(RateReal) < sizeof(Real) ? "float" : "double";
+
+    const accuracy_t err = accuracy(states);
+
+    // report
+
+    std::cout << "network: NumSpec = " << NumSpec << ", NumRates = " << NumRates
+              << ", Jacobian nonzeros = " << sparse_jac_t::nnz
+              << ", " << nstates << " states, " << nreps << " repetitions" << std::endl;
+    std::cout << "rates stored as " << rate_precision << std::endl;
+    std::cout << std::endl;
+
+    std::cout << std::left << std::setw(28) << "kernel" << std::right
+              << std::setw(12) << "ns/call"
+              << std::setw(12) << "min"
+              << std::setw(12) << "stddev"
+              << std::setw(14) << "calls/s" << std::endl;
+
+    for (const auto& r : results) {
+        std::cout << std::left << std::setw(28) << r.name << std::right << std::fixed
+                  << std::setprecision(2)
+                  << std::setw(12) << r.median
+                  << std::setw(12) << r.min
+                  << std::setw(12) << r.stddev
+                  << std::scientific << std::setprecision(3)
+                  << std::setw(14) << 1.e9 / r.median << std::endl;
+    }
+
+    std::cout << std::endl << "largest relative error vs. rates stored in double:" << std::endl
+              << std::scientific << std::setprecision(3)
+              << "  rates " << err.rates << ", ydot " << err.ydot
+              << ", enuc " << err.enuc << ", jac " << err.jac << std::endl
+              << "largest relative error of the finite difference Jacobian: "
+              << err.jac_fd << " (" << jac_coloring::NumColors << " colors)" << std::endl;
+
+    std::ofstream json(json_file);
+
+    json << std::setprecision(6);
+    json << "{" << std::endl;
+    json << "  \"num_spec\": " << NumSpec << "," << std::endl;
+    json << "  \"num_rates\": " << NumRates << "," << std::endl;
+    json << "  \"jac_nnz\": " << sparse_jac_t::nnz << "," << std::endl;
+    json << "  \"num_states\": " << nstates << "," << std::endl;
+    json << "  \"repetitions\": " << nreps << "," << std::endl;
+    json << "  \"simd_width\": " << simd::native_width << "," << std::endl;
+    json << "  \"rate_precision\": \"" << rate_precision << "\"," << std::endl;
+    json << "  \"accuracy\": {\"rates\": " << err.rates << ", \"ydot\": " << err.ydot
+         << ", \"enuc\": " << err.enuc << ", \"jac\": " << err.jac
+         << ", \"jac_fd\": " << err.jac_fd << "}," << std::endl;
+#if defined(__VERSION__)
+    json << "  \"compiler\": \"" << __VERSION__ << "\"," << std::endl;
+#endif
+    json << "  \"kernels\": [" << std::endl;
+
+    for (std::size_t k = 0; k < results.size(); ++k) {
+        const auto& r = results[k];
+        json << "    {\"name\": \"" << r.name << "\", "
+             << "\"calls_per_rep\": " << r.calls_per_rep << ", "
+             << "\"ns_per_call\": {\"median\": " << r.median
+             << ", \"mean\": " << r.mean
+             << ", \"min\": " << r.min
+             << ", \"stddev\": " << r.stddev << "}, "
+             << "\"calls_per_sec\": " << 1.e9 / r.median << ", "
+             << "\"samples\": [";
+        for (std::size_t n = 0; n < r.ns_per_call.size(); ++n) {
+            json << (n > 0 ? ", " : "") << r.ns_per_call[n];
+        }
+        json << "]}" << (k + 1 < results.size() ? "," : "") << std::endl;
+    }
+
+    json << "  ]" << std::endl;
+    json << "}" << std::endl;
+
+    std::cout << std::endl << "results written to " << json_file << std::endl;
+
+}
@@ -0,0 +1,127 @@
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <utility>
+
+#include <rate_table.H>
+#include <reaclib_rates.H>
+
+namespace rate_table
+{
+    table_t table;
+
+    namespace
+    {
+
+        // fill the grid points of t with the exact rates
+
+        void tabulate (table_t& t)
+        {
+            t.data.assign(static_cast<std::size_t>(2 * stride) * t.npts, 0.0_rt);
+
+            rate_derivs_t rate_eval;
+
+            for (int i = 0; i < t.npts; ++i) {
+                const Real lnT9 = t.lnT9_lo + i * t.dlnT9;
+                const tf_t tfactors = evaluate_tfactors(std::exp(lnT9) * 1.e9_rt);
+                fill_reaclib_rates<1, rate_derivs_t>(tfactors, rate_eval);
+
+                Real* f = &t.data[static_cast<std::size_t>(2 * stride) * i];
+                for (int n = 0; n < NumTabulated; ++n) {
+                    const Real rate = rate_eval.screened_rates(rates[n]);
+                    const Real drate_dT = rate_eval.dscreened_rates_dT(rates[n]);
+
+                    // the fits floor each set at exp(-230), so a rate can
+                    // only be zero if there is a problem with its data
+
+                    f[n] = std::max(std::log(std::max(rate, std::numeric_limits<Real>::min())), -230.0_rt);
+                    f[stride + n] = rate > 0.0_rt ? drate_dT * tfactors.T9 * 1.e9_rt / rate * t.dlnT9 : 0.0_rt;
+                }
+            }
+        }
+
+        // the largest relative error of the interpolated rates, checked
+        // at the quarter points of each interval.  Rates below exp(-200)
+        // are negligible and are skipped, since the floor on the fits
+        // makes them kinked there.
+
+        Real check (const table_t& t)
+        {
+            Real err{0.0};
+
+            rate_derivs_t rate_eval;
+            rates_t interp;
+
+            for (int i = 0; i < t.npts - 1; ++i) {
+                for (const Real s : {0.25_rt, 0.5_rt, 0.75_rt}) {
+                    const Real T = std::exp(t.lnT9_lo + (i + s) * t.dlnT9) * 1.e9_rt;
+                    const tf_t tfactors = evaluate_tfactors(T);
+
+                    fill_reaclib_rates<1, rate_derivs_t>(tfactors, rate_eval);
+                    interpolate<1>(t, tfactors, interp);
+
+                    for (int n = 0; n < NumTabulated; ++n) {
+                        const Real rate = rate_eval.screened_rates(rates[n]);
+                        if (!(rate > std::exp(-200.0_rt))) {
+                            continue;
+                        }
+                        err = std::max(err, std::abs(interp.rate[n] - rate) / rate);
+
+                        // the error in d ln(rate) / d ln(T)
+                        const Real dlnr = rate_eval.dscreened_rates_dT(rates[n]) * T / rate;
+                        const Real dlnr_interp = interp.drate_dT[n] * T / interp.rate[n];
+                        err = std::max(err, std::abs(dlnr_interp - dlnr) / std::max(1.0_rt, std::abs(dlnr)));
+                    }
+                }
+            }
+
+            return err;
+        }
+
+    }
+
+    Real build (const Real T_min, const Real T_max, const Real rtol)
+    {
+
+        // any existing table would be used by fill_reaclib_rates, so
+        // discard it first
+
+        table = table_t{};
+
+        if (NumTabulated == 0 || !(T_max > T_min)) {
+            return 0.0_rt;
+        }
+
+        const Real lnT9_lo = std::log(T_min / 1.e9_rt);
+        const Real lnT9_hi = std::log(T_max / 1.e9_rt);
+
+        const std::size_t max_npts = max_bytes / (2 * stride * sizeof(Real));
+
+        // start with 16 points per decade and double until the target
+        // accuracy is reached
+
+        int nint = std::max(1, static_cast<int>(std::ceil((lnT9_hi - lnT9_lo) / std::log(10.0_rt) * 16)));
+
+        table_t t;
+
+        while (true) {
+            t.npts = nint + 1;
+            t.lnT9_lo = lnT9_lo;
+            t.dlnT9 = (lnT9_hi - lnT9_lo) / nint;
+            t.dlnT9_inv = 1.0_rt / t.dlnT9;
+
+            tabulate(t);
+            t.max_error = check(t);
+
+            if (t.max_error <= rtol || static_cast<std::size_t>(2 * nint + 1) > max_npts) {
+                break;
+            }
+            nint *= 2;
+        }
+
+        table = std::move(t);
+
+        return table.max_error;
+    }
+
+}
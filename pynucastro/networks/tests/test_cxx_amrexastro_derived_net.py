@@ -1,9 +1,12 @@
 # unit test for C++ network with derived rates using partition functions
+import io
 import shutil
 
+import numpy as np
 import pytest
 
 import pynucastro as pyna
+from pynucastro.rates import Tfactors
 
 
 class TestAmrexAstroCxxNetwork:
@@ -44,3 +47,91 @@ class TestAmrexAstroCxxNetwork:
 
         # clean up generated files if the test passed
         shutil.rmtree(test_path)
+
+    def test_pf_cache(self, fn):
+        """ the partition functions should be interpolated once per
+        state, searching each temperature grid once, and the derived
+        rates should read them from the cache"""
+
+        output = io.StringIO()
+        fn._fill_pf_cache(1, output)
+        fill = output.getvalue()
+
+        temp_arrays, _ = fn.dedupe_partition_function_temperatures()
+        assert fill.count("find_pf_index") == len(temp_arrays)
+        for n in fn.get_nuclei_needing_partition_functions():
+            assert fill.count(f"pf_cache.{n}_pf,") == 1
+
+        for r in fn.derived_rates:
+            assert r.pf_nuclei()
+            rate = r.function_string_cxx(dtype=fn.dtype, specifiers=fn.function_specifier)
+            assert "const pf_cache_t& pf_cache" in rate
+            assert "get_partition_function" not in rate
+
+    def test_derived_from_forward(self, reaclib_library):
+        """ with derived_from_forward, a derived rate with several sets
+        should scale its forward rate instead of evaluating its sets"""
+
+        fwd_rates = reaclib_library.get_rate_by_name(["o16(a,g)ne20", "ne20(a,g)mg24"])
+        derived = [pyna.DerivedRate(rate=r, compute_Q=False, use_pf=True) for r in fwd_rates]
+
+        # every set should differ from its forward set by the same offset
+        for d in derived:
+            a0, a1, a6 = d.detailed_balance_a
+            for s, s_fwd in zip(d.sets, d.rate.sets):
+                assert s.a[0] == pytest.approx(s_fwd.a[0] + a0)
+                assert s.a[1] == pytest.approx(s_fwd.a[1] + a1)
+                assert s.a[6] == pytest.approx(s_fwd.a[6] + a6)
+
+        net = pyna.AmrexAstroCxxNetwork(rates=fwd_rates + derived, derived_from_forward=True)
+        assert len(net._derived_forward_rates()) == len(derived)
+
+        output = io.StringIO()
+        net._fill_reaclib_rates(1, output)
+        fill = output.getvalue()
+
+        for d in derived:
+            fwd = d.rate.cname()
+            assert fill.count(f"const Real rate_fwd_{fwd} = rate;") == 1
+            assert f"(tfactors, pf_cache, rate_fwd_{fwd}, drate_fwd_{fwd}_dT, rate, drate_dT);" in fill
+
+            rate = d.function_string_cxx(dtype=net.dtype, specifiers=net.function_specifier,
+                                         from_forward=True)
+            assert "ln_set_rate" not in rate
+            assert rate.count("std::exp(") == 1
+
+    def test_derived_from_forward_values(self, reaclib_library):
+        """ scaling the floored forward rate should give the derived
+        rate evaluated set by set, down to T9 = 0.01, and derived rates
+        where it would not (endothermic forward rates) should be
+        evaluated set by set"""
+
+        def floored_rate(sets, tf):
+            return sum(np.exp(max(np.dot(s.a, tf.array), -230.0)) for s in sets)
+
+        fwd_rates = reaclib_library.get_rate_by_name(["o16(a,g)ne20", "ne20(a,g)mg24",
+                                                      "ne22(a,n)mg25"])
+        derived = [pyna.DerivedRate(rate=r, compute_Q=False, use_pf=False) for r in fwd_rates]
+
+        for d in derived:
+            scaled = []
+            direct = []
+            for T9 in np.logspace(-2, 1, 200):
+                tf = Tfactors(T9 * 1.0e9)
+                a0, a1, a6 = d.detailed_balance_a
+                ln_db = a0 + a1 * tf.T9i + a6 * tf.lnT9
+                scaled.append(np.exp(ln_db) * floored_rate(d.rate.sets, tf))
+                direct.append(floored_rate(d.sets, tf))
+            scaled = np.array(scaled)
+            direct = np.array(direct)
+
+            # the sets floored in the forward rate are not floored again
+            big = direct > 1.e-80
+            agrees = np.allclose(scaled[big], direct[big], rtol=1.e-10, atol=0.0) and \
+                np.all(scaled[~big] < 1.e-80)
+            assert agrees == d.can_scale_forward()
+
+        assert not derived[-1].can_scale_forward()
+
+        net = pyna.AmrexAstroCxxNetwork(rates=fwd_rates + derived, derived_from_forward=True)
+        assert set(net._derived_forward_rates()) == {d.cname() for d in derived[:-1]}
@@ -1,7 +1,11 @@
 # unit tests for rates
 import io
+import os
 import shutil
+import struct
+import subprocess
 
+import numpy as np
 import pytest
 
 from pynucastro import networks
@@ -75,13 +79,41 @@ class TestAmrexAstroCxxNetwork:
                   '        ebind_per_nucleon(Mg23) = 7.901115_rt;\n')
         assert self.cromulent_ftag(fn._ebind, answer, n_indent=2)
 
+    def test_table_groups(self, fn):
+        """ the Suzuki tables share their grids, so they should be
+        stored together and evaluated at once"""
+
+        groups = fn._table_groups()
+        assert [(name, len(rates)) for name, rates in groups] == [("table_group_1", 2)]
+
+        output = io.StringIO()
+        fn._compute_tabular_rates(1, output)
+        rates = output.getvalue()
+        assert rates.count("evaluate_all_tabular_rates(") == 1
+        for k, r in enumerate(fn._tabular_rate_order(), 1):
+            assert f"rate_eval.screened_rates(k_{r.cname()}) = rate({k});" in rates
+
+    def test_table_loads(self, fn):
+        """ each table should be read by exactly one load, and only the
+        first table of a group should write the grids"""
+
+        output = io.StringIO()
+        fn._table_loads(1, output)
+        loads = output.getvalue()
+
+        for name, rates in fn._table_groups():
+            for t in rates:
+                assert loads.count(f'"{t.table_file}"') == 1
+            assert loads.count(f", {name}_rhoy, {name}_temp, table);") == 1
+
     def test_write_network(self, fn, compare_network_files):
         """ test the write_network function"""
         test_path = "_test_cxx/"
         # subdirectory of pynucastro/networks/tests/
         reference_path = "_amrexastro_cxx_reference/"
         # files that will be ignored if present in the generated directory
-        skip_files = []
+        # -- the binary tables are checked by test_binary_tables
+        skip_files = [r.table_binary_file for r in fn.tabular_rates]
 
         # remove any previously generated files
         shutil.rmtree(test_path, ignore_errors=True)
@@ -90,3 +122,126 @@ class TestAmrexAstroCxxNetwork:
 
         # clean up generated files if the test passed
         shutil.rmtree(test_path)
+
+    def test_binary_tables(self, fn, tmp_path):
+        """ the binary tables should hold the same values as the text
+        tables, in the order described in table_rates.H"""
+        fn.write_network(odir=str(tmp_path))
+
+        for r in fn.tabular_rates:
+            with open(tmp_path / r.table_binary_file, "rb") as f:
+                raw = f.read()
+
+            assert raw[:8] == b"PYNATAB\0"
+            version, ntemp, nrhoy, nvars, rhoy_off, temp_off, data_off, source_size, source_mtime = \
+                struct.unpack("<iiiiqqqqq", raw[8:64])
+            assert version == 3
+
+            source = (tmp_path / r.table_file).stat()
+            assert (source_size, source_mtime) == (source.st_size, source.st_mtime_ns)
+            assert (ntemp, nrhoy, nvars) == (r.table_temp_lines, r.table_rhoy_lines,
+                                             r.table_num_vars)
+            assert rhoy_off % 64 == temp_off % 64 == data_off % 64 == 0
+
+            rhoy = np.frombuffer(raw, "<f8", nrhoy, rhoy_off)
+            temp = np.frombuffer(raw, "<f8", ntemp, temp_off)
+            data = np.frombuffer(raw, "<f8", nvars*nrhoy*ntemp, data_off).reshape(nvars, nrhoy, ntemp)
+
+            table = r.tabular_data_table
+            assert np.array_equal(np.repeat(rhoy, ntemp), table[:, 0])
+            assert np.array_equal(np.tile(temp, nrhoy), table[:, 1])
+            assert np.array_equal(data.transpose(1, 2, 0).reshape(-1, nvars), table[:, 2:])
+
+    @pytest.mark.skipif(shutil.which("g++") is None, reason="needs a C++ compiler")
+    def test_binary_table_reads(self, fn, tmp_path):
+        """ when the binary tables are current, init_tabular should only
+        look at the size and time of the text tables, never their
+        contents, and it should parse the text tables once they change"""
+        fn.write_network(odir=str(tmp_path))
+
+        # just enough of AMReX to build table_rates.H on the host
+        stubs = {
+            "AMReX_Array.H": """#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+using Real = double;
+constexpr Real operator""_rt(long double x) { return static_cast<Real>(x); }
+#define AMREX_INLINE inline
+#define AMREX_GPU_HOST_DEVICE
+#define AMREX_GPU_MANAGED
+namespace amrex {
+inline void Error(const char* m) { std::cerr << m << std::endl; std::abort(); }
+template <class T, int XLO, int XHI> struct Array1D {
+    T arr[XHI-XLO+1];
+    T& operator()(int i) { return arr[i-XLO]; }
+    const T& operator()(int i) const { return arr[i-XLO]; } };
+template <class T, int XLO, int XHI, int YLO, int YHI, int ZLO, int ZHI> struct Array3D {
+    T arr[(XHI-XLO+1)*(YHI-YLO+1)*(ZHI-ZLO+1)];
+    T& operator()(int i, int j, int k) { return arr[(i-XLO) + (XHI-XLO+1)*((j-YLO) + (YHI-YLO+1)*(k-ZLO))]; }
+    const T& operator()(int i, int j, int k) const { return arr[(i-XLO) + (XHI-XLO+1)*((j-YLO) + (YHI-YLO+1)*(k-ZLO))]; } };
+template <class T> T Clamp(T x, T lo, T hi) { return std::min(std::max(x, lo), hi); }
+}
+""",
+            "AMReX_Print.H": """#pragma once
+#include <iostream>
+namespace amrex { inline std::ostream& Print() { return std::cout; } }
+""",
+            "extern_parameters.H": """#pragma once
+inline int lazy_tabular_tables = 0;
+""",
+            "main.cpp": f"""#include <cstdio>
+#include <extern_parameters.H>
+#include <table_rates.H>
+int main() {{
+    init_tabular();
+    Array1D<Real, 1, {len(fn.tabular_rates)}> rate, drate_dt, edot_nu, edot_gamma;
+    evaluate_all_tabular_rates(3.e8, 6.e8, rate, drate_dt, edot_nu, edot_gamma);
+    for (int k = 1; k <= {len(fn.tabular_rates)}; ++k) {{
+        std::printf("%a %a\\n", rate(k), edot_nu(k));
+    }}
+}}
+"""}
+        for name, text in stubs.items():
+            (tmp_path / name).write_text(text)
+
+        subprocess.run(["g++", "-std=c++17", "-I.", "main.cpp", "table_rates_data.cpp",
+                        "-pthread", "-o", "tabular"], cwd=tmp_path, check=True)
+
+        def run():
+            return subprocess.run(["./tabular"], cwd=tmp_path, capture_output=True, text=True)
+
+        rates = run()
+        assert rates.returncode == 0
+
+        # overwrite the text tables with garbage of the same size and
+        # time: the binary tables are still used, so the text is not read
+        for r in fn.tabular_rates:
+            table = tmp_path / r.table_file
+            st = table.stat()
+            table.write_bytes(b"x" * st.st_size)
+            os.utime(table, ns=(st.st_atime_ns, st.st_mtime_ns))
+
+        assert run().stdout == rates.stdout
+
+        # once a text table has a different time, it is parsed instead
+        table = tmp_path / fn.tabular_rates[0].table_file
+        st = table.stat()
+        os.utime(table, ns=(st.st_atime_ns, st.st_mtime_ns + 1_000_000_000))
+        assert run().stdout != rates.stdout
+
+    def test_tabular_interpolation(self, fn, tmp_path):
+        """ cubic interpolation in temperature should store the slopes of
+        the rate, neutrino loss and gamma energy with the tables"""
+        net = networks.AmrexAstroCxxNetwork(rates=fn.rates, tabular_interpolation="cubic")
+        net.write_network(odir=str(tmp_path))
+
+        with open(tmp_path / "table_rates.H") as f:
+            tables = f.read()
+        assert "constexpr bool tabular_cubic_temp = true;" in tables
+        for name, rates in net._table_groups():
+            assert f"Array3D<Real, 1, {len(rates)} * packed_vars, " in tables
+
+        with pytest.raises(ValueError):
+            networks.AmrexAstroCxxNetwork(rates=fn.rates, tabular_interpolation="spline")
@@ -0,0 +1,111 @@
+# unit tests for the binary network description
+import os
+
+import numpy as np
+import pytest
+
+import pynucastro as pyna
+from pynucastro.networks import (read_network_description,
+                                 write_network_description,
+                                 write_runtime_engine)
+from pynucastro.networks.network_description import (APPROX_AP_PG,
+                                                     DERIVED_PF, REACLIB,
+                                                     TABULAR)
+
+
+class TestNetworkDescription:
+    @pytest.fixture(scope="class")
+    def rc(self, reaclib_library, suzuki_library):
+        rate_names = ["c12(c12,a)ne20",
+                      "c12(c12,n)mg23",
+                      "c12(c12,p)na23",
+                      "c12(a,g)o16",
+                      "n(,)p"]
+        rates = reaclib_library.get_rate_by_name(rate_names)
+
+        tabular_rate_names = ["na23(,)ne23",
+                              "ne23(,)na23"]
+        tabular_rates = suzuki_library.get_rate_by_name(tabular_rate_names)
+
+        return pyna.RateCollection(rates=rates+tabular_rates)
+
+    @pytest.fixture(scope="class")
+    def desc(self, rc, tmp_path_factory):
+        filename = tmp_path_factory.mktemp("desc") / "net.bin"
+        rc.write_network_description(filename)
+        return read_network_description(filename), filename
+
+    def test_nuclei(self, rc, desc):
+        d, _ = desc
+        assert d["num_spec"][0] == len(rc.unique_nuclei)
+        assert d["nuclei.name"] == [str(n) for n in rc.unique_nuclei]
+        assert list(d["nuclei.A"]) == [n.A for n in rc.unique_nuclei]
+        assert list(d["nuclei.Z"]) == [n.Z for n in rc.unique_nuclei]
+
+    def test_rates(self, rc, desc):
+        d, _ = desc
+        assert d["rates.name"] == [r.cname() for r in rc.all_rates]
+        assert len(d["rates.set_ptr"]) == len(rc.all_rates) + 1
+
+        for k, r in enumerate(rc.all_rates):
+            lo, hi = d["rates.reactant_ptr"][k:k+2]
+            assert [d["nuclei.name"][i] for i in d["rates.reactants"][lo:hi]] == \
+                [str(n) for n in r.reactants]
+            if r.tabular:
+                assert d["rates.type"][k] == TABULAR
+                assert d["tables.file"][d["rates.table"][k]] == r.table_file
+            else:
+                assert d["rates.type"][k] == REACLIB
+                lo, hi = d["rates.set_ptr"][k:k+2]
+                a = d["sets.a"][7*lo:7*hi].reshape(-1, 7)
+                assert np.array_equal(a, np.array([s.a for s in r.sets]))
+
+    def test_screening(self, rc, desc):
+        d, _ = desc
+        # 3 carbon rates share the C12 + C12 screening
+        assert len(d["screen.Z1"]) == 2
+        assert sorted(np.diff(d["screen.rate_ptr"])) == [1, 3]
+
+    def test_tables_copied(self, rc, desc):
+        _, filename = desc
+        for r in rc.tabular_rates:
+            assert os.path.isfile(os.path.join(os.path.dirname(filename), r.table_file))
+
+    def test_types(self, reaclib_library, tmp_path):
+        lib = reaclib_library.linking_nuclei(["he4", "c12", "o16", "ne20", "mg24", "si28",
+                                              "p", "al27"])
+        rc = pyna.RateCollection(libraries=[lib])
+        rc.make_ap_pg_approx()
+        rc.remove_nuclei(["al27"])
+
+        # replace the ReacLib reverse of C12(a,g)O16 with a derived rate
+        reverse = reaclib_library.get_rate_by_name("o16(,a)c12")
+        derived = pyna.DerivedRate(rate=reaclib_library.get_rate_by_name("c12(a,g)o16"),
+                                   compute_Q=False, use_pf=True)
+        rc = pyna.RateCollection(rates=[r for r in rc.get_rates() if r != reverse] + [derived])
+
+        write_network_description(rc, tmp_path / "net.bin")
+        d = read_network_description(tmp_path / "net.bin")
+
+        # the rates making up the approximation, and their nuclei, are
+        # included after those of the network
+        assert len(d["rates.type"]) == len(rc.all_rates)
+        assert len(d["nuclei.A"]) > len(rc.unique_nuclei)
+        assert list(d["rates.type"]).count(APPROX_AP_PG) == len(d["approx.rate"]) == 2
+        assert len(d["approx.terms"]) == 5 * len(d["approx.rate"])
+        assert list(d["rates.type"]).count(DERIVED_PF) == 1
+
+        # partition functions are stored for the derived rate's nuclei
+        assert len(d["pf.ptr"]) == len(d["nuclei.A"]) + 1
+        assert len(d["pf.T9"]) == len(d["pf.log10"]) > 0
+
+    def test_bad_file(self, tmp_path):
+        filename = tmp_path / "bad.bin"
+        filename.write_bytes(b"not a network")
+        with pytest.raises(ValueError):
+            read_network_description(filename)
+
+    def test_write_runtime_engine(self, tmp_path):
+        write_runtime_engine(tmp_path)
+        for f in ["runtime_network.H", "runtime_main.cpp", "GNUmakefile"]:
+            assert os.path.isfile(tmp_path / f)
@@ -3,7 +3,7 @@ import shutil
 
 import pytest
 
-from pynucastro import networks
+from pynucastro import Nucleus, networks
 
 
 class TestSimpleCxxNetwork:
@@ -34,3 +34,179 @@ class TestSimpleCxxNetwork:
 
         # clean up generated files if the test passed
         shutil.rmtree(test_path)
+
+    def test_jacobian_sparsity(self, fn):
+        """ the CSR pattern should hold exactly the non-null entries"""
+        row_ptr, col_index = fn.get_jacobian_sparsity()
+
+        n = len(fn.unique_nuclei)
+        assert len(row_ptr) == n + 1
+        assert row_ptr[-1] == len(col_index)
+
+        for irow in range(n):
+            cols = col_index[row_ptr[irow]:row_ptr[irow+1]]
+            assert cols == sorted(cols)
+            for jcol in range(n):
+                assert (jcol in cols) == (not fn.jac_null_entries[n*irow + jcol])
+
+    def test_lu_sparsity(self, fn):
+        """ the LU pattern should contain the Jacobian, the diagonal,
+        and be closed under elimination"""
+        row_ptr, col_index = fn.get_jacobian_sparsity()
+        lu_row_ptr, lu_col_index = fn.get_lu_sparsity()
+
+        n = len(fn.unique_nuclei)
+        rows = [set(lu_col_index[lu_row_ptr[i]:lu_row_ptr[i+1]]) for i in range(n)]
+
+        for i in range(n):
+            assert i in rows[i]
+            assert set(col_index[row_ptr[i]:row_ptr[i+1]]) <= rows[i]
+
+        for k in range(n):
+            for i in range(k+1, n):
+                if k in rows[i]:
+                    assert {j for j in rows[k] if j > k} <= rows[i]
+
+    def test_jacobian_cse(self, fn):
+        """ products that differ only by their coefficient should be
+        computed once, and no coefficient should be a bare 1.0"""
+        temps, entries = fn.get_jacobian_cse()
+
+        code = [value for _, value in temps] + list(entries.values())
+        assert not any("1.0*" in c for c in code)
+
+        # the C12 rates appear in the dY(C12)/dY(C12) entry with a
+        # coefficient of -2 and in the other entries with 1, so that
+        # entry should be made only of temporaries
+        n = len(fn.unique_nuclei)
+        ic12 = fn.unique_nuclei.index(Nucleus("c12"))
+        assert "screened_rates(" not in entries[n*ic12 + ic12]
+
+        values = [value for _, value in temps]
+        assert len(values) == len(set(values))
+
+    def test_flux_rhs(self, fn, tmp_path):
+        """ with flux_rhs, rhs_nuc should go through the fluxes"""
+        net = networks.SimpleCxxNetwork(rates=fn.rates, flux_rhs=True)
+        net.write_network(odir=str(tmp_path / "flux"))
+
+        with open(tmp_path / "flux" / "actual_rhs.H") as f:
+            rhs = f.read()
+
+        body = rhs.split("void rhs_nuc(")[1].split("\n}\n")[0]
+        assert "rate_fluxes(state, Y, screened_rates, flux);" in body
+        assert "rhs_from_fluxes(flux, ydot_nuc);" in body
+
+        # every rate that appears gets a flux
+        for r in net.rates:
+            assert f"flux(k_{r.cname()}) =" in rhs
+
+    def test_reaclib_matrix(self, fn, tmp_path):
+        """ with reaclib_matrix, the sets should be written as a table
+        instead of as functions"""
+        net = networks.SimpleCxxNetwork(rates=fn.rates, reaclib_matrix=True)
+        net.write_network(odir=str(tmp_path / "matrix"))
+
+        with open(tmp_path / "matrix" / "reaclib_rates.H") as f:
+            rates = f.read()
+        with open(tmp_path / "matrix" / "reaclib_matrix.H") as f:
+            matrix = f.read()
+
+        fit_rates = net.reaclib_rates + net.derived_rates
+        for r in fit_rates:
+            assert f"void rate_{r.cname()}(" not in rates
+        assert "fill_reaclib_rates_matrix<do_T_derivatives>(tfactors, rate_eval);" in rates
+
+        nsets = sum(len(r.sets) for r in fit_rates)
+        assert f"constexpr int NumSets = {nsets};" in matrix
+        assert f"constexpr int NumFitRates = {len(fit_rates)};" in matrix
+
+    def test_mixed_precision(self, fn, tmp_path):
+        """ with mixed_precision, the rates should be stored as float and
+        floored to stay normal floats"""
+        net = networks.SimpleCxxNetwork(rates=fn.rates, mixed_precision=True)
+        net.write_network(odir=str(tmp_path / "mixed"))
+
+        with open(tmp_path / "mixed" / "amrex_bridge.H") as f:
+            assert "using RateReal = float;" in f.read()
+
+        with open(tmp_path / "mixed" / "reaclib_rates.H") as f:
+            rates = f.read()
+        assert "Array1D<RateReal, 1, NumRates>  screened_rates;" in rates
+        assert "ln_set_rate = std::max(ln_set_rate, -87.0);" in rates
+        assert "-230.0" not in rates
+
+    def test_fd_jacobian(self, fn, tmp_path):
+        """ with fd_jacobian, the sparsity pattern should be found from the
+        rates alone, and no rate should have two reactants of one color"""
+        net = networks.SimpleCxxNetwork(rates=fn.rates, fd_jacobian=True)
+        assert net.get_jacobian_sparsity() == fn.get_jacobian_sparsity()
+
+        colors = net.get_jacobian_coloring()
+        n = len(net.unique_nuclei)
+        assert sorted(j for cols in colors for j in cols) == list(range(n))
+
+        color_of = {j: c for c, cols in enumerate(colors) for j in cols}
+        for r in net.rates:
+            reactants = {net.unique_nuclei.index(nuc) for nuc in r.reactants}
+            assert len({color_of[j] for j in reactants}) == len(reactants)
+
+        net.write_network(odir=str(tmp_path / "fd"))
+
+        with open(tmp_path / "fd" / "actual_rhs.H") as f:
+            rhs = f.read()
+        assert "jac_nuc_fd(state, jac, Y, screened_rates);" in rhs
+        assert "jac_tmp" not in rhs
+
+    def test_split_sources(self, fn, tmp_path):
+        """ with split_sources, each rate function and each species' RHS
+        and Jacobian row should be written to exactly one source file"""
+        nchunks = 3
+        net = networks.SimpleCxxNetwork(rates=fn.rates, split_sources=nchunks)
+        odir = tmp_path / "split"
+        net.write_network(odir=str(odir))
+
+        def read(name):
+            with open(odir / name) as f:
+                return f.read()
+
+        # only declarations are left in the header
+        assert "ln_set_rate = std::max(ln_set_rate" not in read("reaclib_rates.H")
+        assert "network_chunks::rhs_nuc" in read("actual_rhs.H")
+
+        rates = "".join(read(f"reaclib_rates_{k}.cpp") for k in range(nchunks))
+        for r in net.rates:
+            assert rates.count(f"void rate_{r.cname()}(const tf_t&") == 1
+            assert rates.count(f"template void rate_{r.cname()}<") == 3
+
+        rhs = "".join(read(f"rhs_nuc_{k}.cpp") for k in range(nchunks))
+        jac = "".join(read(f"jac_nuc_{k}.cpp") for k in range(nchunks))
+        for n in net.unique_nuclei:
+            assert rhs.count(f"ydot_nuc({n.cindex()}) =") == 1
+        row_ptr, _ = net.get_jacobian_sparsity()
+        assert jac.count("jac.set(") == jac.count("jac.data[") == row_ptr[-1]
+
+        # writing with fewer files removes the extra ones, and files
+        # that are unchanged are not rewritten
+        mtime = (odir / "actual_rhs.H").stat().st_mtime_ns
+        net = networks.SimpleCxxNetwork(rates=fn.rates, split_sources=1)
+        net.write_network(odir=str(odir))
+        assert not (odir / "rhs_nuc_1.cpp").exists()
+        assert (odir / "actual_rhs.H").stat().st_mtime_ns == mtime
+
+    def test_profile_rates(self, fn, tmp_path):
+        """ with profile_rates, each rate function call should be timed"""
+        net = networks.SimpleCxxNetwork(rates=fn.rates, profile_rates=True)
+        odir = tmp_path / "profile"
+        net.write_network(odir=str(odir))
+
+        assert (odir / "rate_profile.H").is_file()
+
+        with open(odir / "reaclib_rates.H") as f:
+            rates = f.read()
+        assert "#include <rate_profile.H>" in rates
+        for r in net.reaclib_rates:
+            assert f"rate_profile::stop(tstart, k_{r.cname()});" in rates
+
+        with open(odir / "bench.cpp") as f:
+            assert "rate_profile::report(std::cout);" in f.read()
@@ -5,6 +5,7 @@ Classes and methods to interface with files storing rate data.
 import io
 import math
 import os
+import struct
 import warnings
 from collections import Counter
 from enum import Enum
@@ -766,6 +767,30 @@ class Rate:
         return self.prefactor * dens_term * y_e_term * Y_term * rate_eval
 
 
+# the binary tables written by TabularRate.write_binary_table
+BINARY_TABLE_MAGIC = b"PYNATAB\0"
+BINARY_TABLE_VERSION = 3
+BINARY_TABLE_ALIGN = 64
+
+
+def _uniform_segments(x, rtol=1.e-6):
+    """split the increasing grid x into the fewest pieces that are
+    each uniformly spaced, returning a list of (index of the first
+    point, first point, spacing).  Neighboring pieces share their
+    end point."""
+
+    segments = []
+    start = 0
+    while start < len(x) - 1:
+        step = x[start+1] - x[start]
+        end = start + 1
+        while end < len(x) - 1 and abs(x[end+1] - x[end] - step) <= rtol * abs(step):
+            end += 1
+        segments.append((start, x[start], (x[end] - x[start]) / (end - start)))
+        start = end
+    return segments
+
+
 class TableIndex(Enum):
     """a simple enum-like container for indexing the electron-capture tables"""
     RHOY = 0
@@ -1209,16 +1234,29 @@ class ReacLibRate(Rate):
         fstring += f"    rate_eval.{self.fname} = rate\n\n"
         return fstring
 
-    def function_string_cxx(self, dtype="double", specifiers="inline", leave_open=False):
+    @staticmethod
+    def _underflow_comment(ln_floor):
+        """the comment describing the floor on ln(set rate)"""
+        if ln_floor == -230.0:
+            return "avoid underflows by zeroing rates in [0.0, 1.e-100]"
+        return f"avoid underflows by flooring the rates at exp({ln_floor})"
+
+    def function_string_cxx(self, dtype="double", specifiers="inline", leave_open=False,
+                            ln_floor=-230.0, extra_args=()):
         """
         Return a string containing C++ function that computes the
-        rate
+        rate.  Each set is floored at exp(ln_floor).  extra_args are
+        declarations of any parameters the function takes after
+        tfactors.
         """
 
+        args = ", ".join(["const tf_t& tfactors", *extra_args, f"{dtype}& rate", f"{dtype}& drate_dT"])
+
         fstring = ""
         fstring += "template <int do_T_derivatives>\n"
-        fstring += f"{specifiers}\n"
-        fstring += f"void rate_{self.cname()}(const tf_t& tfactors, {dtype}& rate, {dtype}& drate_dT) {{\n\n"
+        if specifiers:
+            fstring += f"{specifiers}\n"
+        fstring += f"void rate_{self.cname()}({args}) {{\n\n"
         fstring += f"    // {self.rid}\n\n"
         fstring += "    rate = 0.0;\n"
         fstring += "    drate_dT = 0.0;\n\n"
@@ -1240,8 +1278,8 @@ class ReacLibRate(Rate):
             fstring += "    }\n"
             fstring += "\n"
 
-            fstring += "    // avoid underflows by zeroing rates in [0.0, 1.e-100]\n"
-            fstring += "    ln_set_rate = std::max(ln_set_rate, -230.0);\n"
+            fstring += f"    // {self._underflow_comment(ln_floor)}\n"
+            fstring += f"    ln_set_rate = std::max(ln_set_rate, {ln_floor});\n"
             fstring += "    set_rate = std::exp(ln_set_rate);\n"
 
             fstring += "    rate += set_rate;\n"
@@ -1255,6 +1293,53 @@ class ReacLibRate(Rate):
 
         return fstring
 
+    def function_string_cxx_simd(self, specifiers="inline", ln_floor=-230.0):
+        """
+        Return a string containing a C++ function that computes the
+        rate for W temperatures at once, using the vreal<W> type.
+        This overloads the scalar function from function_string_cxx.
+        """
+
+        fstring = ""
+        fstring += "template <int do_T_derivatives, int W>\n"
+        if specifiers:
+            fstring += f"{specifiers}\n"
+        fstring += f"void rate_{self.cname()}(const tf_simd_t<W>& tfactors, vreal<W>& rate, vreal<W>& drate_dT) {{\n\n"
+        fstring += f"    // {self.rid}\n\n"
+        fstring += "    rate = 0.0;\n"
+        fstring += "    drate_dT = 0.0;\n\n"
+        fstring += "    vreal<W> ln_set_rate{0.0};\n"
+        fstring += "    vreal<W> dln_set_rate_dT9{0.0};\n"
+        fstring += "    vreal<W> set_rate{0.0};\n\n"
+
+        for s in self.sets:
+            fstring += f"    // {s.labelprops[0:5]}\n"
+            set_string = s.set_string_cxx(prefix="ln_set_rate", plus_equal=False, with_exp=False)
+            for t in set_string.split("\n"):
+                fstring += "    " + t + "\n"
+            fstring += "\n"
+
+            fstring += "    if constexpr (do_T_derivatives) {\n"
+            dln_set_string_dT9 = s.dln_set_string_dT9_cxx(prefix="dln_set_rate_dT9", plus_equal=False)
+            for t in dln_set_string_dT9.split("\n"):
+                fstring += "        " + t + "\n"
+            fstring += "    }\n"
+            fstring += "\n"
+
+            fstring += f"    // {self._underflow_comment(ln_floor)}\n"
+            fstring += f"    ln_set_rate = simd::max(ln_set_rate, {ln_floor});\n"
+            fstring += "    set_rate = simd::exp(ln_set_rate);\n"
+
+            fstring += "    rate += set_rate;\n"
+
+            fstring += "    if constexpr (do_T_derivatives) {\n"
+            fstring += "        drate_dT += set_rate * dln_set_rate_dT9 / 1.0e9;\n"
+            fstring += "    }\n\n"
+
+        fstring += "}\n\n"
+
+        return fstring
+
     def eval(self, T, rhoY=None):
         """ evauate the reaction rate for temperature T """
 
@@ -1535,6 +1620,7 @@ class TabularRate(Rate):
             raise RateFileError(f'Nucleus objects could not be identified in {self.original_source}') from ex
 
         self.table_file = s2.strip()
+        self.table_binary_file = os.path.splitext(self.table_file)[0] + ".bin"
         self.table_header_lines = int(s3.strip())
         self.table_rhoy_lines = int(s4.strip())
         self.table_temp_lines = int(s5.strip())
@@ -1623,6 +1709,54 @@ class TabularRate(Rate):
         # convert the nested list of string values into a numpy float array
         self.tabular_data_table = np.array(t_data2d, dtype=np.float64)
 
+        # the log(rhoY) and log(T) grids, split into the pieces that
+        # are uniformly spaced, so an index can be found directly
+        ntemp = self.table_temp_lines
+        self.table_rhoy_segments = _uniform_segments(self.tabular_data_table[::ntemp, TableIndex.RHOY.value])
+        self.table_temp_segments = _uniform_segments(self.tabular_data_table[:ntemp, TableIndex.T.value])
+
+    def write_binary_table(self, filename, source_file=None):
+        """write the table as a binary file that the C++ networks can
+        map into memory instead of parsing the text table.  The file
+        is little-endian, with a 64 byte header with an 8 byte magic
+        string (``PYNATAB`` followed by a null byte), the format
+        version, ntemp, nrhoy and nvars as 32-bit integers, the
+        offsets of log(rhoY), log(T) and the data, and the size and
+        modification time (in ns) of the text table source_file (by
+        default, the one the table was read from) as 64-bit integers;
+        then the log(rhoY) and log(T) values as doubles, and the data,
+        as doubles indexed as data[var][rhoy][temp].  Each array
+        starts at a multiple of 64 bytes.  The C++ networks only use
+        the binary table if the text table next to it still has the
+        recorded size and modification time."""
+
+        ntemp = self.table_temp_lines
+        nrhoy = self.table_rhoy_lines
+        nvars = self.table_num_vars
+
+        table = self.tabular_data_table.reshape(nrhoy, ntemp, nvars + 2)
+
+        arrays = [table[:, 0, TableIndex.RHOY.value],
+                  table[0, :, TableIndex.T.value],
+                  table[:, :, TableIndex.MU.value:].transpose(2, 0, 1)]
+
+        offsets = []
+        offset = BINARY_TABLE_ALIGN
+        for a in arrays:
+            offsets.append(offset)
+            offset += -(-a.size * 8 // BINARY_TABLE_ALIGN) * BINARY_TABLE_ALIGN
+
+        source = os.stat(source_file or self.table_path)
+
+        with open(filename, "wb") as f:
+            header = BINARY_TABLE_MAGIC + struct.pack("<iiiiqqqqq", BINARY_TABLE_VERSION,
+                                                      ntemp, nrhoy, nvars, *offsets,
+                                                      source.st_size, source.st_mtime_ns)
+            f.write(header.ljust(BINARY_TABLE_ALIGN, b"\0"))
+            for a, start in zip(arrays, offsets):
+                f.write(b"\0" * (start - f.tell()))
+                f.write(np.ascontiguousarray(a, dtype="<f8").tobytes())
+
     def eval(self, T, rhoY=None):
         """ evauate the reaction rate for temperature T """
 
@@ -1768,6 +1902,12 @@ class DerivedRate(ReacLibRate):
             sset_d = SingleSet(a=a_rev, labelprops=rate.labelprops)
             derived_sets.append(sset_d)
 
+        # every set differs from its forward set by the same
+        # ln(rate) offset, a0 + a1 / T9 + a6 ln(T9)
+        self.detailed_balance_a = (prefactor,
+                                   -Q / (1.0e9 * constants.k_MeV),
+                                   1.5*(len(self.rate.reactants) - len(self.rate.products)))
+
         super().__init__(rfile=self.rate.rfile, chapter=self.rate.chapter, original_source=self.rate.original_source,
                 reactants=self.rate.products, products=self.rate.reactants, sets=derived_sets, labelprops="derived", Q=-Q)
 
@@ -1837,15 +1977,39 @@ class DerivedRate(ReacLibRate):
 
         return fstring
 
-    def function_string_cxx(self, dtype="double", specifiers="inline", leave_open=False):
+    def pf_nuclei(self):
+        """Return the nuclei whose partition functions this rate
+        interpolates from tables -- none if use_pf is False.  In C++,
+        these are read from the pf_cache_t of the state."""
+
+        if not self.use_pf:
+            return []
+        return sorted({nuc for nuc in self.rate.reactants + self.rate.products
+                       if nuc.partition_function})
+
+    def function_string_cxx(self, dtype="double", specifiers="inline", leave_open=False,
+                            ln_floor=-230.0, from_forward=False):
         """
         Return a string containing C++ function that computes the
-        rate
+        rate.  If it needs any partition functions, it takes a
+        pf_cache_t holding them as well.  If from_forward is True, the
+        function takes the forward rate and its temperature derivative,
+        already evaluated, and scales them by the detailed balance
+        factor instead of evaluating the sets again.
         """
 
         self._warn_about_missing_pf_tables()
 
-        fstring = super().function_string_cxx(dtype=dtype, specifiers=specifiers, leave_open=True)
+        extra_args = []
+        if self.pf_nuclei():
+            extra_args.append("const pf_cache_t& pf_cache")
+
+        if from_forward:
+            fstring = self._from_forward_string_cxx(dtype=dtype, specifiers=specifiers,
+                                                    extra_args=extra_args)
+        else:
+            fstring = super().function_string_cxx(dtype=dtype, specifiers=specifiers, leave_open=True,
+                                                  ln_floor=ln_floor, extra_args=extra_args)
 
         # right now we have rate and drate_dT without the partition function
         # now the partition function corrections
@@ -1857,8 +2021,9 @@ class DerivedRate(ReacLibRate):
                 fstring += f"    Real {nuc}_pf, d{nuc}_pf_dT;\n"
 
                 if nuc.partition_function:
-                    fstring += f"    // interpolating {nuc} partition function\n"
-                    fstring += f"    get_partition_function({nuc.cindex()}, tfactors, {nuc}_pf, d{nuc}_pf_dT);\n"
+                    fstring += f"    // {nuc} partition function, interpolated once for the state\n"
+                    fstring += f"    {nuc}_pf = pf_cache.{nuc}_pf;\n"
+                    fstring += f"    d{nuc}_pf_dT = pf_cache.d{nuc}_pf_dT;\n"
                 else:
                     fstring += f"    // setting {nuc} partition function to 1.0 by default, independent of T\n"
                     fstring += f"    {nuc}_pf = 1.0_rt;\n"
@@ -1902,6 +2067,71 @@ class DerivedRate(ReacLibRate):
 
         return fstring
 
+    def can_scale_forward(self):
+        """Return True if this rate can be computed by scaling its
+        forward rate by exp(offset), the ln(rate) offset between each
+        set and its forward set.  This needs a1 <= 0 in the offset
+        (an exothermic forward rate): otherwise, at low T the offset
+        turns the exp(-230) floor of the forward sets into a huge
+        rate."""
+
+        return self.detailed_balance_a[1] <= 0.0
+
+    def _from_forward_string_cxx(self, dtype="double", specifiers="inline", extra_args=()):
+        """
+        Return the start of a C++ function that computes the rate,
+        without partition functions, from the forward rate: since
+        every set differs from its forward set by the same ln(rate)
+        offset, the rate is the forward rate times exp(offset).  Sets
+        that were floored in the forward rate are not floored again.
+        """
+
+        if not self.can_scale_forward():
+            raise ValueError(f"{self.rid} cannot be computed from its endothermic forward rate")
+
+        a0, a1, a6 = self.detailed_balance_a
+
+        args = ", ".join(["const tf_t& tfactors", *extra_args,
+                          f"const {dtype} rate_fwd", f"const {dtype} drate_fwd_dT",
+                          f"{dtype}& rate", f"{dtype}& drate_dT"])
+
+        ln_terms = [f"{a0}", f"{a1} * tfactors.T9i"]
+        dln_terms = [f"{-a1} * tfactors.T9i * tfactors.T9i"]
+        if a6 != 0.0:
+            ln_terms.append(f"{a6} * tfactors.lnT9")
+            dln_terms.append(f"{a6} * tfactors.T9i")
+
+        fstring = ""
+        fstring += "template <int do_T_derivatives>\n"
+        if specifiers:
+            fstring += f"{specifiers}\n"
+        fstring += f"void rate_{self.cname()}({args}) {{\n\n"
+        fstring += f"    // {self.rid}, from {self.rate.rid} by detailed balance\n\n"
+        fstring += "    drate_dT = 0.0;\n\n"
+
+        fstring += f"    {dtype} ln_db = {' + '.join(ln_terms)};\n"
+        fstring += f"    {dtype} dln_db_dT9 = {' + '.join(dln_terms)};\n\n"
+
+        fstring += f"    {dtype} db_factor = std::exp(ln_db);\n"
+        fstring += "    rate = db_factor * rate_fwd;\n"
+        fstring += "    if constexpr (do_T_derivatives) {\n"
+        fstring += "        drate_dT = db_factor * drate_fwd_dT + rate * dln_db_dT9 / 1.0e9;\n"
+        fstring += "    }\n\n"
+
+        return fstring
+
+    def function_string_cxx_simd(self, specifiers="inline", ln_floor=-230.0):
+        """
+        Return a string containing a C++ function that computes the
+        rate for W temperatures at once.  Partition functions are not
+        supported here.
+        """
+
+        if self.use_pf:
+            raise NotImplementedError("partition functions are not supported in the SIMD rates")
+
+        return super().function_string_cxx_simd(specifiers=specifiers, ln_floor=ln_floor)
+
     def counter_factors(self):
         """This function returns the nucr! = nucr_1! * ... * nucr_r!
         for each repeated nucr reactant and nucp! = nucp_1! * ... *
@@ -453,3 +453,26 @@ class TestTabularRates:
 
         with raises(ValueError):
             r.eval(T, rhoy)
+
+    def test_grid_segments(self, rc_su, rc_la):
+
+        # the Suzuki tables are uniform above log10(rhoY) = 8 and
+        # log10(T) = 8, with a coarser point below
+        r = rc_su.get_rates()[0]
+        assert [(i, x0) for i, x0, _ in r.table_rhoy_segments] == [(0, 7.0), (1, 8.0)]
+        assert [(i, x0) for i, x0, _ in r.table_temp_segments] == [(0, 7.0), (5, 8.0)]
+        assert r.table_rhoy_segments[1][2] == approx(0.02)
+        assert r.table_temp_segments[1][2] == approx(0.05)
+
+        # the Langanke tables are uniform in rhoY only
+        r = rc_la.get_rates()[0]
+        assert len(r.table_rhoy_segments) == 1
+        assert len(r.table_temp_segments) > 4
+
+        # every grid point is on its segment
+        for segments, x in [(r.table_rhoy_segments, r.tabular_data_table[::r.table_temp_lines, 0]),
+                            (r.table_temp_segments, r.tabular_data_table[:r.table_temp_lines, 1])]:
+            ends = [i for i, _, _ in segments[1:]] + [len(x) - 1]
+            for (i0, x0, dx), i1 in zip(segments, ends):
+                for i in range(i0, i1 + 1):
+                    assert x[i] == approx(x0 + (i - i0) * dx)